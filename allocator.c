@@ -53,5 +53,6 @@ struct allocator_traits default_allocator = {
     default_allocator_del,      // del
     default_allocator_eq,       // eq
     default_allocator_alloc,    // alloc
-    default_allocator_dealloc   // dealloc
+    default_allocator_dealloc,  // dealloc
+    NULL                        // dealloc_batch, free() has nothing to batch
 };
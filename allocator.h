@@ -15,6 +15,8 @@ typedef int(*allocator_eq_t)(allocator_ptr_t, allocator_ptr_t);
 
 typedef void*(*allocator_alloc_t)(allocator_ptr_t, size_t);
 typedef void(*allocator_dealloc_t)(allocator_ptr_t, void*, size_t);
+// release 'count' blocks at once, each of 'n' elements
+typedef void(*allocator_dealloc_batch_t)(allocator_ptr_t, void**, size_t, size_t);
 
 struct allocator_traits {
     allocator_new_t         new;
@@ -25,6 +27,8 @@ struct allocator_traits {
 
     allocator_alloc_t       alloc;
     allocator_dealloc_t     dealloc;
+    // optional, NULL means every block is handed to dealloc on its own
+    allocator_dealloc_batch_t dealloc_batch;
 };
 
 extern struct allocator_traits default_allocator;
@@ -0,0 +1,149 @@
+// traversal of a large list with nodes from malloc and from the huge page pool
+//
+// build from the repository root:
+//   cc -std=gnu99 -O2 -I. -o hugepage_traverse bench/hugepage_traverse.c
+//      llist.c hugepage_allocator.c allocator.c thread_pool.c -lpthread
+//
+// usage: hugepage_traverse [nodes] [passes] [malloc|hugepage|both]
+// the list is sorted by random keys after it has been filled, so that the
+// traversal order is unrelated to the address order as in a long-lived
+// list. dTLB load misses of the traversal passes are counted through
+// perf_event_open, they read n/a where the kernel does not allow it
+// (see /proc/sys/kernel/perf_event_paranoid) or has no such event
+#ifndef _GNU_SOURCE
+#	define	_GNU_SOURCE
+#endif
+
+#include "llist.h"
+#include "hugepage_allocator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+static double bench_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// return -1 if the counter is not available
+static int bench_perf_open(uint32_t type, uint64_t config) {
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size           = sizeof(attr);
+	attr.type           = type;
+	attr.config         = config;
+	attr.disabled       = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv     = 1;
+
+	return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void bench_perf_start(int fd) {
+	if(fd >= 0) {
+		ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+}
+
+// return -1 if the counter is not available
+static long long bench_perf_stop(int fd) {
+	uint64_t count;
+
+	if(fd < 0)
+		return -1;
+	ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+	if(read(fd, &count, sizeof(count)) != (ssize_t) sizeof(count))
+		return -1;
+	return (long long) count;
+}
+
+static int bench_cmp_long(const void* lhs, const void* rhs) {
+	long l = *(const long*) lhs, r = *(const long*) rhs;
+	return (l > r) - (l < r);
+}
+
+// kB of anonymous memory backed by transparent huge pages
+static long bench_anon_huge_kb(void) {
+	FILE* f = fopen("/proc/self/smaps_rollup", "r");
+	char line[256];
+	long kb = -1;
+
+	if(f == NULL)
+		return -1;
+	while(fgets(line, sizeof(line), f) != NULL)
+		if(sscanf(line, "AnonHugePages: %ld kB", &kb) == 1)
+			break;
+	fclose(f);
+	return kb;
+}
+
+static void bench_run(const char* name, struct allocator_traits traits,
+			long nodes, int passes) {
+	int dtlb_fd = bench_perf_open(PERF_TYPE_HW_CACHE,
+		PERF_COUNT_HW_CACHE_DTLB
+		| (PERF_COUNT_HW_CACHE_OP_READ << 8)
+		| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+	int cycles_fd = bench_perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	llist_s lst;
+	const lnode_s* p;
+	long i, sum = 0;
+	long long misses, cycles;
+	double start, ms;
+	int pass;
+
+	llist_construct(&lst, sizeof(long), traits, traits);
+
+	srand(1);
+	for(i = 0; i < nodes; ++i) {
+		long key = rand();
+		llist_push_back(&lst, &key);
+	}
+	llist_sort_pred(&lst, bench_cmp_long);
+
+	bench_perf_start(dtlb_fd);
+	bench_perf_start(cycles_fd);
+	start = bench_now();
+	for(pass = 0; pass < passes; ++pass)
+		for(p = lst.head; p != NULL; p = p->next)
+			sum += *(const long*) p->data;
+	ms     = (bench_now() - start) * 1e3 / passes;
+	misses = bench_perf_stop(dtlb_fd);
+	cycles = bench_perf_stop(cycles_fd);
+
+	printf("%-8s %10ld nodes %9.1f ms/pass %7.2f ns/node", name, nodes, ms, ms * 1e6 / nodes);
+	if(misses >= 0)
+		printf(" %13.0f dTLB misses/pass %6.3f per node",
+			(double) misses / passes, (double) misses / passes / nodes);
+	else
+		printf("  dTLB misses n/a");
+	if(cycles >= 0)
+		printf(" %7.1f cycles/node", (double) cycles / passes / nodes);
+	printf(" AnonHugePages %ld kB (checksum %ld)\n", bench_anon_huge_kb(), sum & 1);
+
+	llist_destroy(&lst);
+	if(dtlb_fd >= 0)
+		close(dtlb_fd);
+	if(cycles_fd >= 0)
+		close(cycles_fd);
+}
+
+int main(int argc, char** argv) {
+	long nodes        = argc > 1 ? atol(argv[1]) : 10000000;
+	int  passes       = argc > 2 ? atoi(argv[2]) : 3;
+	const char* which = argc > 3 ? argv[3] : "both";
+
+	if(strcmp(which, "hugepage") != 0)
+		bench_run("malloc", default_allocator, nodes, passes);
+	if(strcmp(which, "malloc") != 0)
+		bench_run("hugepage", hugepage_allocator, nodes, passes);
+	return 0;
+}
@@ -0,0 +1,163 @@
+// lru_s under a Zipf-distributed get-or-put workload
+//
+// build from the repository root:
+//   cc -std=gnu99 -O2 -I. -o lru_zipf bench/lru_zipf.c lru.c llist.c
+//      allocator.c thread_pool.c -lpthread -lm
+//      -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc
+//
+// usage: lru_zipf [keys] [capacity] [operations] [skew]
+// every operation looks a key up and puts it on a miss. the first half of
+// the operations warms the cache up, the second half is measured and the
+// allocations made during it are counted through the --wrap hooks
+#ifndef _GNU_SOURCE
+#	define	_GNU_SOURCE
+#endif
+
+#include "lru.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+// allocation hooks, the linker routes every malloc, calloc and realloc
+// call of the program to these
+static long bench_allocs;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* p, size_t size);
+
+void* __wrap_malloc(size_t size) {
+	++bench_allocs;
+	return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+	++bench_allocs;
+	return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* p, size_t size) {
+	++bench_allocs;
+	return __real_realloc(p, size);
+}
+
+static double bench_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// xorshift64*, rand() is too coarse on platforms with a small RAND_MAX
+static uint64_t bench_rng_state = 0x9e3779b97f4a7c15ULL;
+
+static double bench_uniform(void) {
+	uint64_t x = bench_rng_state;
+
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	bench_rng_state = x;
+	return ((x * 0x2545f4914f6cdd1dULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Zipf over ranks [0, n): rank k is drawn with probability
+// proportional to 1 / (k + 1)^skew, by inverting the tabulated cdf
+struct bench_zipf {
+	double* cdf;
+	size_t  n;
+};
+
+static void bench_zipf_init(struct bench_zipf* z, size_t n, double skew) {
+	double sum = 0;
+	size_t i;
+
+	z->cdf = (double*) malloc(n * sizeof(double));
+	z->n   = n;
+	for(i = 0; i < n; ++i) {
+		sum += 1.0 / pow((double) (i + 1), skew);
+		z->cdf[i] = sum;
+	}
+	for(i = 0; i < n; ++i)
+		z->cdf[i] /= sum;
+}
+
+static size_t bench_zipf_next(const struct bench_zipf* z) {
+	double u = bench_uniform();
+	size_t lo = 0, hi = z->n - 1;
+
+	while(lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if(z->cdf[mid] < u)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static long bench_evictions;
+
+static void bench_on_evict(const void* key, void* value, void* ctx) {
+	Macro_declare_unused(key);
+	Macro_declare_unused(value);
+	Macro_declare_unused(ctx);
+
+	++bench_evictions;
+}
+
+int main(int argc, char** argv) {
+	size_t keys     = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+	size_t capacity = argc > 2 ? strtoul(argv[2], NULL, 10) : 100000;
+	size_t ops      = argc > 3 ? strtoul(argv[3], NULL, 10) : 10000000;
+	double skew     = argc > 4 ? atof(argv[4]) : 0.99;
+	struct bench_zipf zipf;
+	uint64_t* trace;
+	lru_s cache;
+	size_t i, hits = 0, warm = ops / 2;
+	long warm_allocs, allocs, evictions;
+	double start, elapsed;
+
+	// the trace is drawn up front so that only the cache is measured,
+	// ranks are scattered over the key space so that hot keys are not
+	// neighbours in the index
+	bench_zipf_init(&zipf, keys, skew);
+	trace = (uint64_t*) malloc(ops * sizeof(uint64_t));
+	for(i = 0; i < ops; ++i)
+		trace[i] = (uint64_t) bench_zipf_next(&zipf) * 0x9e3779b97f4a7c15ULL;
+
+	lru_construct(&cache, capacity, sizeof(uint64_t), sizeof(uint64_t), NULL, NULL);
+	lru_set_evict(&cache, bench_on_evict, NULL);
+
+	for(i = 0; i < warm; ++i)
+		if(lru_get(&cache, &trace[i]) == NULL)
+			lru_put(&cache, &trace[i], &trace[i]);
+
+	warm_allocs = bench_allocs;
+	evictions   = bench_evictions;
+	start       = bench_now();
+	for(i = warm; i < ops; ++i) {
+		if(lru_get(&cache, &trace[i]) != NULL)
+			++hits;
+		else
+			lru_put(&cache, &trace[i], &trace[i]);
+	}
+	elapsed   = bench_now() - start;
+	allocs    = bench_allocs - warm_allocs;
+	evictions = bench_evictions - evictions;
+
+	printf("zipf(%.2f) over %zu keys, capacity %zu, %zu measured operations\n",
+		skew, keys, capacity, ops - warm);
+	printf("%.2f Mops/s, %.1f ns/op, hit rate %.1f%%, %ld evictions\n",
+		(ops - warm) / elapsed / 1e6, elapsed * 1e9 / (ops - warm),
+		100.0 * hits / (ops - warm), evictions);
+	// a zero count up to the end of the warm-up means the hooks are not linked in
+	printf("%ld allocations up to the end of the warm-up, %ld while measured\n",
+		warm_allocs, allocs);
+
+	lru_destroy(&cache);
+	free(trace);
+	free(zipf.cdf);
+	return 0;
+}
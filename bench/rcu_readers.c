@@ -0,0 +1,178 @@
+// reader scaling of llist_rcu against an llist guarded by a rwlock
+//
+// build from the repository root:
+//   cc -std=gnu99 -O2 -I. -o rcu_readers bench/rcu_readers.c
+//      llist.c llist_rcu.c allocator.c thread_pool.c -lpthread
+//
+// usage: rcu_readers [max_readers] [length] [writer_period_us] [ms]
+// readers run 1, 2, 4, ... up to max_readers (default: twice the online
+// cpus) threads, each walking the whole list and summing its payloads,
+// while one writer erases the head and appends a node every period
+#ifndef _GNU_SOURCE
+#	define	_GNU_SOURCE
+#endif
+
+#include "llist_rcu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MAX_READERS 256
+
+enum bench_mode { BENCH_RWLOCK, BENCH_RCU };
+
+static struct {
+	enum bench_mode  mode;
+	llist_rcu_s      rcu;
+	llist_s          plain;
+	pthread_rwlock_t lock;
+
+	int              stop;
+	long             writer_period_us;
+} bench;
+
+struct bench_reader {
+	pthread_t thread;
+	long      traversals;
+	long      sum;
+};
+
+static double bench_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int bench_stopped(void) {
+	return __atomic_load_n(&bench.stop, __ATOMIC_RELAXED);
+}
+
+static void* bench_reader_main(void* arg) {
+	struct bench_reader* self = (struct bench_reader*) arg;
+	struct llist_rcu_reader reader;
+	const lnode_s* p;
+	long sum = 0;
+
+	if(bench.mode == BENCH_RCU)
+		llist_rcu_register(&bench.rcu, &reader);
+
+	while(!bench_stopped()) {
+		if(bench.mode == BENCH_RCU) {
+			llist_rcu_read_lock(&bench.rcu, &reader);
+			for(p = llist_rcu_first(&bench.rcu); p != NULL; p = llist_rcu_next(p))
+				sum += *(const long*) p->data;
+			llist_rcu_read_unlock(&reader);
+		} else {
+			pthread_rwlock_rdlock(&bench.lock);
+			for(p = bench.plain.head; p != NULL; p = p->next)
+				sum += *(const long*) p->data;
+			pthread_rwlock_unlock(&bench.lock);
+		}
+		++self->traversals;
+	}
+
+	if(bench.mode == BENCH_RCU)
+		llist_rcu_unregister(&bench.rcu, &reader);
+
+	self->sum = sum;
+	return NULL;
+}
+
+static void* bench_writer_main(void* arg) {
+	long key = 0;
+
+	Macro_declare_unused(arg);
+	while(!bench_stopped()) {
+		if(bench.mode == BENCH_RCU) {
+			llist_rcu_erase(&bench.rcu, bench.rcu.list.head);
+			llist_rcu_push_back(&bench.rcu, &key);
+		} else {
+			pthread_rwlock_wrlock(&bench.lock);
+			llist_erase(&bench.plain, bench.plain.head);
+			llist_push_back(&bench.plain, &key);
+			pthread_rwlock_unlock(&bench.lock);
+		}
+		++key;
+		if(bench.writer_period_us > 0)
+			usleep(bench.writer_period_us);
+	}
+	return NULL;
+}
+
+// return the traversals per second of all readers together
+static double bench_run(int readers, long ms) {
+	static struct bench_reader r[BENCH_MAX_READERS];
+	pthread_t writer;
+	double start, elapsed;
+	long total = 0;
+	int i;
+
+	bench.stop = 0;
+	for(i = 0; i < readers; ++i) {
+		r[i].traversals = 0;
+		pthread_create(&r[i].thread, NULL, bench_reader_main, &r[i]);
+	}
+	pthread_create(&writer, NULL, bench_writer_main, NULL);
+
+	start = bench_now();
+	usleep(ms * 1000);
+	__atomic_store_n(&bench.stop, 1, __ATOMIC_RELAXED);
+
+	for(i = 0; i < readers; ++i) {
+		pthread_join(r[i].thread, NULL);
+		total += r[i].traversals;
+	}
+	pthread_join(writer, NULL);
+	elapsed = bench_now() - start;
+
+	return total / elapsed;
+}
+
+int main(int argc, char** argv) {
+	long cpus    = sysconf(_SC_NPROCESSORS_ONLN);
+	int  max     = argc > 1 ? atoi(argv[1]) : (int) (cpus > 0 ? 2 * cpus : 2);
+	long length  = argc > 2 ? atol(argv[2]) : 1024;
+	long ms      = argc > 4 ? atol(argv[4]) : 1000;
+	int  readers, mode;
+	long i;
+
+	bench.writer_period_us = argc > 3 ? atol(argv[3]) : 1000;
+	if(max > BENCH_MAX_READERS)
+		max = BENCH_MAX_READERS;
+
+	pthread_rwlock_init(&bench.lock, NULL);
+	llist_construct_def(&bench.plain, sizeof(long));
+	llist_rcu_construct_def(&bench.rcu, sizeof(long));
+	for(i = 0; i < length; ++i) {
+		llist_push_back(&bench.plain, &i);
+		llist_rcu_push_back(&bench.rcu, &i);
+	}
+
+	printf("%ld online cpus, %ld nodes, a write every %ld us, %ld ms per run\n",
+		cpus, length, bench.writer_period_us, ms);
+	printf("%-7s %7s %16s %10s %9s\n",
+		"mode", "readers", "traversals/s", "per reader", "scaling");
+
+	for(mode = BENCH_RWLOCK; mode <= BENCH_RCU; ++mode) {
+		double base = 0;
+
+		bench.mode = (enum bench_mode) mode;
+		for(readers = 1; readers <= max; readers *= 2) {
+			double rate = bench_run(readers, ms);
+
+			if(readers == 1)
+				base = rate;
+			printf("%-7s %7d %16.0f %10.0f %8.2fx\n",
+				mode == BENCH_RCU ? "rcu" : "rwlock",
+				readers, rate, rate / readers, rate / base);
+		}
+	}
+
+	llist_rcu_synchronize(&bench.rcu);
+	llist_rcu_destroy(&bench.rcu);
+	llist_destroy(&bench.plain);
+	pthread_rwlock_destroy(&bench.lock);
+	return 0;
+}
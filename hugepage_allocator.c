@@ -0,0 +1,198 @@
+// MAP_ANONYMOUS, MAP_HUGETLB and MADV_HUGEPAGE are not POSIX
+#ifndef _GNU_SOURCE
+#	define	_GNU_SOURCE
+#endif
+
+#include "hugepage_allocator.h"
+#include <stddef.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#define HUGEPAGE_SIZE           ((size_t) 2 << 20)
+#define HUGEPAGE_REGION_MIN     HUGEPAGE_SIZE
+#define HUGEPAGE_REGION_MAX     ((size_t) 1 << 30)
+#define HUGEPAGE_BLOCK_ALIGN    64
+
+// blocks are aligned for any type, as malloc'ed ones are
+union hugepage_max_align {
+    long double ld;
+    long long   ll;
+    void*       p;
+    void      (*f)(void);
+};
+
+struct hugepage_max_align_probe {
+    char                     c;
+    union hugepage_max_align u;
+};
+
+#define HUGEPAGE_MAX_ALIGN      offsetof(struct hugepage_max_align_probe, u)
+
+struct hugepage_region {
+    struct hugepage_region* next;
+    size_t                  size;
+};
+
+struct hugepage_pool {
+    size_t                  block_size;
+    void*                   free;       // free blocks linked through their first word
+    char*                   cur;        // unused tail of the newest region
+    char*                   end;
+    struct hugepage_region* regions;
+    size_t                  next_region_size;
+};
+
+static size_t hugepage_round_up(size_t n, size_t align) {
+    return (n + align - 1) / align * align;
+}
+
+static void* hugepage_map(size_t size) {
+    void* p;
+
+#ifdef MAP_HUGETLB
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(p != MAP_FAILED)
+        return p;
+#endif
+
+    // over-map so the region can be trimmed to a huge page boundary
+    p = mmap(NULL, size + HUGEPAGE_SIZE, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(p == MAP_FAILED)
+        return NULL;
+    else {
+        char*  base = (char*) p;
+        char*  aligned = (char*) hugepage_round_up((uintptr_t) base, HUGEPAGE_SIZE);
+        size_t head = (size_t) (aligned - base);
+
+        if(head != 0)
+            munmap(base, head);
+        if(HUGEPAGE_SIZE - head != 0)
+            munmap(aligned + size, HUGEPAGE_SIZE - head);
+
+#ifdef MADV_HUGEPAGE
+        madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+        return aligned;
+    }
+}
+
+static int hugepage_grow(struct hugepage_pool* pool, size_t need) {
+    size_t header = hugepage_round_up(sizeof(struct hugepage_region), HUGEPAGE_BLOCK_ALIGN);
+    size_t size = pool->next_region_size;
+    struct hugepage_region* region;
+
+    while(size - header < need)
+        size *= 2;
+
+    region = (struct hugepage_region*) hugepage_map(size);
+    if(region == NULL)
+        return 0;
+
+    region->next  = pool->regions;
+    region->size  = size;
+    pool->regions = region;
+    pool->cur     = (char*) region + header;
+    pool->end     = (char*) region + size;
+
+    if(pool->next_region_size < HUGEPAGE_REGION_MAX)
+        pool->next_region_size *= 2;
+    return 1;
+}
+
+static allocator_ptr_t hugepage_allocator_new(size_t elem_size) {
+    struct hugepage_pool* ret = malloc(sizeof(struct hugepage_pool));
+
+    // a multiple of the maximum alignment also holds the free list link
+    ret->block_size = hugepage_round_up(elem_size ? elem_size : 1, HUGEPAGE_MAX_ALIGN);
+    ret->free       = NULL;
+    ret->cur        = NULL;
+    ret->end        = NULL;
+    ret->regions    = NULL;
+    ret->next_region_size = HUGEPAGE_REGION_MIN;
+    return ret;
+}
+
+static allocator_ptr_t hugepage_allocator_copy(allocator_ptr_t o) {
+    return hugepage_allocator_new(((struct hugepage_pool*) o)->block_size);
+}
+
+static allocator_ptr_t hugepage_allocator_move(allocator_ptr_t o) {
+    return o;
+}
+
+static void hugepage_allocator_del(allocator_ptr_t o) {
+    struct hugepage_pool* pool = (struct hugepage_pool*) o;
+
+    while(pool->regions != NULL) {
+        struct hugepage_region* region = pool->regions;
+        pool->regions = region->next;
+        munmap(region, region->size);
+    }
+    free(pool);
+}
+
+static int hugepage_allocator_eq(allocator_ptr_t l, allocator_ptr_t r) {
+    return l == r;
+}
+
+static void* hugepage_allocator_alloc(allocator_ptr_t a, size_t n) {
+    struct hugepage_pool* pool = (struct hugepage_pool*) a;
+    size_t need = pool->block_size * n;
+    void*  ret;
+
+    if(n == 1 && pool->free != NULL) {
+        ret = pool->free;
+        pool->free = *(void**) ret;
+        return ret;
+    }
+
+    if((size_t) (pool->end - pool->cur) < need && !hugepage_grow(pool, need))
+        return NULL;
+
+    ret = pool->cur;
+    pool->cur += need;
+    return ret;
+}
+
+static void hugepage_allocator_dealloc(allocator_ptr_t a, void* p, size_t n) {
+    struct hugepage_pool* pool = (struct hugepage_pool*) a;
+    char* block = (char*) p;
+
+    for(; n > 0; --n, block += pool->block_size) {
+        *(void**) block = pool->free;
+        pool->free = block;
+    }
+}
+
+static void hugepage_allocator_dealloc_batch(allocator_ptr_t a, void** p,
+                        size_t count, size_t n) {
+    if(n == 1) {
+        struct hugepage_pool* pool = (struct hugepage_pool*) a;
+        size_t i;
+
+        if(count == 0)
+            return;
+
+        // chain the blocks in order, then prepend the chain at once
+        for(i = 0; i + 1 < count; ++i)
+            *(void**) p[i] = p[i + 1];
+        *(void**) p[count - 1] = pool->free;
+        pool->free = p[0];
+    } else
+        for(; count > 0; --count, ++p)
+            hugepage_allocator_dealloc(a, *p, n);
+}
+
+struct allocator_traits hugepage_allocator = {
+    hugepage_allocator_new,             // new
+    hugepage_allocator_copy,            // copy
+    hugepage_allocator_move,            // move
+    hugepage_allocator_del,             // del
+    hugepage_allocator_eq,              // eq
+    hugepage_allocator_alloc,           // alloc
+    hugepage_allocator_dealloc,         // dealloc
+    hugepage_allocator_dealloc_batch    // dealloc_batch
+};
@@ -0,0 +1,14 @@
+#ifndef HUGEPAGE_ALLOCATOR_H_GUARD_
+#define HUGEPAGE_ALLOCATOR_H_GUARD_
+
+#include "allocator.h"
+
+// node pool carving fixed-size blocks out of large mmap'ed regions backed
+// by huge pages where possible: explicit ones (MAP_HUGETLB) first, then
+// transparent ones (MADV_HUGEPAGE), then plain pages
+//
+// blocks are only reused within one pool, so two pools never compare equal
+// and lists using it exchange nodes by relinking only if they share it
+extern struct allocator_traits hugepage_allocator;
+
+#endif
@@ -1,9 +1,16 @@
+// pthread_rwlock_t is not part of plain C99
+#ifndef _POSIX_C_SOURCE
+#	define	_POSIX_C_SOURCE 200112L
+#endif
+
 #include "llist.h"
 #include "utils.h"
 #include "compat.h"
+#include "thread_pool.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 
 static inline void* llist_impl_alloc_data(llist_s* lst) {
 	return lst->data_alloc_traits.alloc(lst->data_alloc_obj, 1);
@@ -21,6 +28,161 @@ static inline void llist_impl_dealloc_node(llist_s* lst, lnode_s* p) {
 	lst->node_alloc_traits.dealloc(lst->node_alloc_obj, p, 1);
 }
 
+// links in the logical direction of 'lst'
+static inline lnode_s** llist_impl_next_link(const llist_s* lst, lnode_s* p) {
+	return lst->reversed ? &p->prev : &p->next;
+}
+
+static inline lnode_s** llist_impl_prev_link(const llist_s* lst, lnode_s* p) {
+	return lst->reversed ? &p->next : &p->prev;
+}
+
+// nodes and payloads are handed back to allocators that support batch
+// deallocation this many at a time, others get them one by one right away
+#define LLIST_IMPL_BATCH 64
+
+struct llist_impl_release {
+	void*  data[LLIST_IMPL_BATCH];
+	void*  nodes[LLIST_IMPL_BATCH];
+	size_t data_cnt;
+	size_t node_cnt;
+	size_t total;
+};
+
+static inline void llist_impl_release_init(struct llist_impl_release* r) {
+	r->data_cnt = 0;
+	r->node_cnt = 0;
+	r->total    = 0;
+}
+
+static inline void llist_impl_release_flush(llist_s* lst, struct llist_impl_release* r) {
+	if(r->data_cnt != 0) {
+		lst->data_alloc_traits.dealloc_batch(lst->data_alloc_obj,
+			r->data, r->data_cnt, 1);
+		r->data_cnt = 0;
+	}
+	if(r->node_cnt != 0) {
+		lst->node_alloc_traits.dealloc_batch(lst->node_alloc_obj,
+			r->nodes, r->node_cnt, 1);
+		r->node_cnt = 0;
+	}
+}
+
+static inline void llist_impl_release_push(llist_s* lst,
+			struct llist_impl_release* r, lnode_s* p) {
+	if(lst->elem_traits.destroy != NULL)
+		lst->elem_traits.destroy(p->data);
+
+	if(lst->data_alloc_traits.dealloc_batch == NULL)
+		llist_impl_dealloc_data(lst, p->data);
+	else {
+		r->data[r->data_cnt++] = p->data;
+		if(r->data_cnt == LLIST_IMPL_BATCH)
+			llist_impl_release_flush(lst, r);
+	}
+
+	if(lst->node_alloc_traits.dealloc_batch == NULL)
+		llist_impl_dealloc_node(lst, p);
+	else {
+		r->nodes[r->node_cnt++] = p;
+		if(r->node_cnt == LLIST_IMPL_BATCH)
+			llist_impl_release_flush(lst, r);
+	}
+
+	++r->total;
+}
+
+// release a detached, NULL-terminated chain linked through 'next'
+// return the number of released nodes
+static size_t llist_impl_release_chain(llist_s* lst, lnode_s* node) {
+	struct llist_impl_release r;
+	lnode_s* next;
+
+	llist_impl_release_init(&r);
+	for(; node != NULL; node = next) {
+		next = node->next;
+		llist_impl_release_push(lst, &r, node);
+	}
+	llist_impl_release_flush(lst, &r);
+	return r.total;
+}
+
+// nodes relinked one after another in the direction of a list, the next
+// link of 'tail' is left as is until the chain is sealed
+struct llist_impl_chain {
+	lnode_s* head;
+	lnode_s* tail;
+};
+
+static inline void llist_impl_chain_init(struct llist_impl_chain* c) {
+	c->head = NULL;
+	c->tail = NULL;
+}
+
+static inline void llist_impl_chain_append(const llist_s* lst,
+			struct llist_impl_chain* c, lnode_s* p) {
+	lnode_s** link = llist_impl_prev_link(lst, p);
+
+	// only touch links that actually change, surviving runs stay clean
+	if(*link != c->tail)
+		*link = c->tail;
+	if(c->tail == NULL)
+		c->head = p;
+	else {
+		link = llist_impl_next_link(lst, c->tail);
+		if(*link != p)
+			*link = p;
+	}
+	c->tail = p;
+}
+
+// single pass rebuild of a list: kept nodes are relinked in order,
+// dropped ones are unlinked and released in batches
+struct llist_impl_filter {
+	struct llist_impl_chain   kept;
+	struct llist_impl_release dropped;
+};
+
+static inline void llist_impl_filter_init(struct llist_impl_filter* f) {
+	llist_impl_chain_init(&f->kept);
+	llist_impl_release_init(&f->dropped);
+}
+
+static inline void llist_impl_filter_keep(const llist_s* lst,
+			struct llist_impl_filter* f, lnode_s* p) {
+	llist_impl_chain_append(lst, &f->kept, p);
+}
+
+static inline void llist_impl_filter_drop(llist_s* lst,
+			struct llist_impl_filter* f, lnode_s* p) {
+	llist_impl_release_push(lst, &f->dropped, p);
+}
+
+static inline void llist_impl_filter_finish(llist_s* lst, struct llist_impl_filter* f) {
+	if(f->kept.tail != NULL)
+		*llist_impl_next_link(lst, f->kept.tail) = NULL;
+
+	llist_impl_release_flush(lst, &f->dropped);
+
+	lst->head  = f->kept.head;
+	lst->tail  = f->kept.tail;
+	lst->size -= f->dropped.total;
+}
+
+static inline void llist_impl_copy_elem(llist_s* lst, void* dst, const void* src) {
+	if(lst->elem_traits.copy != NULL)
+		lst->elem_traits.copy(dst, src);
+	else
+		memcpy(dst, src, lst->elem_size);
+}
+
+static inline void llist_impl_move_elem(llist_s* lst, void* dst, void* src) {
+	if(lst->elem_traits.move != NULL)
+		lst->elem_traits.move(dst, src);
+	else
+		memcpy(dst, src, lst->elem_size);
+}
+
 static inline int llist_impl_allocator_eq(llist_s* lhs, llist_s* rhs) {
 	return lhs->node_alloc_traits.eq(lhs->node_alloc_obj, rhs->node_alloc_obj)
 	    && lhs->data_alloc_traits.eq(lhs->data_alloc_obj, rhs->data_alloc_obj);
@@ -34,9 +196,269 @@ static inline void llist_impl_init_data(llist_s* lst, size_t elem_size,
 
 	lst->elem_size  = elem_size;
 	lst->size       = 0;
+	lst->reversed   = 0;
+
+	lst->elem_traits.copy    = NULL;
+	lst->elem_traits.move    = NULL;
+	lst->elem_traits.destroy = NULL;
 
 	lst->data_alloc_traits = data_alloc_traits;
 	lst->node_alloc_traits = node_alloc_traits;
+
+	lst->shared     = NULL;
+}
+
+// empty list sharing the allocator objects of 'owner', must not outlive it
+// and is never destroyed
+static inline void llist_impl_init_borrowed(llist_s* lst, const llist_s* owner) {
+	llist_impl_init_data(lst, owner->elem_size,
+		owner->data_alloc_traits, owner->node_alloc_traits);
+	lst->data_alloc_obj = owner->data_alloc_obj;
+	lst->node_alloc_obj = owner->node_alloc_obj;
+	lst->elem_traits    = owner->elem_traits;
+	lst->reversed       = owner->reversed;
+}
+
+// link the detached chain [first, last], already running in the direction
+// of 'lst', before 'pos', the size is left to the caller
+static inline void llist_impl_link_range(llist_s* lst, lnode_s* pos,
+			lnode_s* first, lnode_s* last) {
+	lnode_s* before = pos != NULL ? llist_prev(lst, pos) : lst->tail;
+
+	*llist_impl_prev_link(lst, first) = before;
+	*llist_impl_next_link(lst, last)  = pos;
+
+	if(before != NULL)
+		*llist_impl_next_link(lst, before) = first;
+	else
+		lst->head = first;
+
+	if(pos != NULL)
+		*llist_impl_prev_link(lst, pos) = last;
+	else
+		lst->tail = last;
+}
+
+// detach [first, last], the size is left to the caller
+static inline void llist_impl_unlink_range(llist_s* lst, lnode_s* first, lnode_s* last) {
+	lnode_s* before = llist_prev(lst, first);
+	lnode_s* after  = llist_next(lst, last);
+
+	if(before != NULL)
+		*llist_impl_next_link(lst, before) = after;
+	else
+		lst->head = after;
+
+	if(after != NULL)
+		*llist_impl_prev_link(lst, after) = before;
+	else
+		lst->tail = before;
+}
+
+// number of nodes in [first, last)
+static inline size_t llist_impl_range_len(const llist_s* lst,
+			const lnode_s* first, const lnode_s* last) {
+	size_t cnt = 0;
+	for(; first != last; first = llist_next(lst, first))
+		++cnt;
+	return cnt;
+}
+
+// append a node whose payload is left uninitialized
+static inline lnode_s* llist_impl_push_back_uninit(llist_s* lst) {
+	lnode_s* new_node = llist_impl_alloc_node(lst);
+	new_node->data    = llist_impl_alloc_data(lst);
+
+	llist_impl_link_range(lst, NULL, new_node, new_node);
+	++lst->size;
+
+	return new_node;
+}
+
+// insert a node before 'pos' whose payload is left uninitialized
+static inline lnode_s* llist_impl_insert_uninit(llist_s* lst, lnode_s* pos) {
+	lnode_s* new_node = llist_impl_alloc_node(lst);
+	new_node->data    = llist_impl_alloc_data(lst);
+
+	llist_impl_link_range(lst, pos, new_node, new_node);
+	++lst->size;
+
+	return new_node;
+}
+
+// unlink 'pos' without releasing it
+static inline void llist_impl_unlink(llist_s* lst, lnode_s* pos) {
+	llist_impl_unlink_range(lst, pos, pos);
+	--lst->size;
+}
+
+// storage shared between a list and its snapshots. the list they were
+// taken from, the origin, keeps its nodes: before modifying them it hands
+// a frozen copy over to the record, which the snapshots read from then on
+struct llist_shared {
+	size_t           refs;     // the origin while attached plus the snapshots
+	pthread_rwlock_t lock;     // held shared while a snapshot is read
+	const llist_s*   origin;   // NULL once the nodes have been handed over
+	llist_s          frozen;   // the shared content after the hand-over
+};
+
+static void llist_impl_destroy_private(llist_s* lst) {
+	llist_clear(lst);
+	lst->node_alloc_traits.del(lst->node_alloc_obj);
+	lst->data_alloc_traits.del(lst->data_alloc_obj);
+}
+
+static struct llist_shared* llist_impl_shared_new(const llist_s* origin) {
+	struct llist_shared* shared =
+		(struct llist_shared*) malloc(sizeof(struct llist_shared));
+
+	shared->refs   = 1;
+	shared->origin = origin;
+	pthread_rwlock_init(&shared->lock, NULL);
+	return shared;
+}
+
+static void llist_impl_shared_drop(struct llist_shared* shared) {
+	if(__atomic_fetch_sub(&shared->refs, 1, __ATOMIC_ACQ_REL) == 1) {
+		if(shared->origin == NULL)
+			llist_impl_destroy_private(&shared->frozen);
+		pthread_rwlock_destroy(&shared->lock);
+		free(shared);
+	}
+}
+
+// snapshots look at 'origin' without taking the lock, it only ever
+// changes to NULL and they are never the origin
+static inline int llist_impl_is_origin(const llist_s* lst) {
+	return __atomic_load_n(&lst->shared->origin, __ATOMIC_RELAXED) == lst;
+}
+
+// the list holding the content of 'lst', see llist_read_begin
+static const llist_s* llist_impl_read_begin(const llist_s* lst) {
+	struct llist_shared* shared = lst->shared;
+
+	if(shared == NULL)
+		return lst;
+
+	pthread_rwlock_rdlock(&shared->lock);
+	return shared->origin != NULL ? lst : &shared->frozen;
+}
+
+static void llist_impl_read_end(const llist_s* lst) {
+	if(lst->shared != NULL)
+		pthread_rwlock_unlock(&lst->shared->lock);
+}
+
+// deep copy of 'src' into fresh allocator objects, node pointers in
+// 'track' are translated from the nodes of 'src' to their copies
+static void llist_impl_copy_storage(llist_s* lst, const llist_s* src,
+			lnode_s** track[], size_t ntrack) {
+	const lnode_s* p;
+	size_t i, missed = 0;
+
+	for(i = 0; i < ntrack; ++i)
+		missed += *track[i] != NULL;
+
+	llist_impl_init_data(lst, src->elem_size,
+		src->data_alloc_traits, src->node_alloc_traits);
+	lst->data_alloc_obj = lst->data_alloc_traits.copy(src->data_alloc_obj);
+	lst->node_alloc_obj = lst->node_alloc_traits.copy(src->node_alloc_obj);
+	lst->elem_traits    = src->elem_traits;
+
+	for(p = src->head; p != NULL; p = llist_next(src, p)) {
+		lnode_s* q = llist_impl_push_back_uninit(lst);
+		llist_impl_copy_elem(lst, q->data, p->data);
+
+		for(i = 0; i < ntrack; ++i)
+			if(*track[i] == p) {
+				*track[i] = q;
+				--missed;
+			}
+	}
+
+	// a pointer taken from a snapshot outside of a read section may refer
+	// to nodes the original list has changed since
+	assert(missed == 0);
+	Macro_declare_unused(missed);
+}
+
+// from now on the snapshots read 'storage', waits for those still reading
+// the nodes of the origin
+static void llist_impl_hand_over(struct llist_shared* shared, const llist_s* storage) {
+	pthread_rwlock_wrlock(&shared->lock);
+	shared->frozen        = *storage;
+	shared->frozen.shared = NULL;
+	__atomic_store_n(&shared->origin, NULL, __ATOMIC_RELAXED);
+	pthread_rwlock_unlock(&shared->lock);
+}
+
+// stop sharing without copying any element, return non-zero if 'lst'
+// still owns its nodes and allocator objects. otherwise they stay with
+// the snapshots and 'lst' is given fresh allocator objects if 'refresh'
+static int llist_impl_leave_shared(llist_s* lst, int refresh) {
+	struct llist_shared* shared = lst->shared;
+	int owns = 0;
+
+	if(llist_impl_is_origin(lst)) {
+		if(__atomic_load_n(&shared->refs, __ATOMIC_ACQUIRE) == 1)
+			owns = 1;
+		else
+			llist_impl_hand_over(shared, lst);
+	}
+
+	if(!owns && refresh) {
+		const llist_s* view = llist_impl_read_begin(lst);
+		lst->data_alloc_obj = view->data_alloc_traits.copy(view->data_alloc_obj);
+		lst->node_alloc_obj = view->node_alloc_traits.copy(view->node_alloc_obj);
+		llist_impl_read_end(lst);
+	}
+
+	lst->shared = NULL;
+	llist_impl_shared_drop(shared);
+	return owns;
+}
+
+// give 'lst' private storage before it is modified. the origin keeps its
+// nodes and hands a copy to the snapshots, a snapshot copies the shared
+// content for itself and node pointers in 'track' are translated
+static void llist_impl_unshare_slow(llist_s* lst, lnode_s** track[], size_t ntrack) {
+	struct llist_shared* shared = lst->shared;
+	const llist_s* view;
+	llist_s copy;
+
+	if(llist_impl_is_origin(lst)) {
+		if(__atomic_load_n(&shared->refs, __ATOMIC_ACQUIRE) != 1) {
+			llist_impl_copy_storage(&copy, lst, NULL, 0);
+			llist_impl_hand_over(shared, &copy);
+		}
+		lst->shared = NULL;
+		llist_impl_shared_drop(shared);
+		return;
+	}
+
+	// the origin is gone and so are the other snapshots, take the nodes
+	if(__atomic_load_n(&shared->refs, __ATOMIC_ACQUIRE) == 1) {
+		*lst = shared->frozen;
+		pthread_rwlock_destroy(&shared->lock);
+		free(shared);
+		return;
+	}
+
+	view = llist_impl_read_begin(lst);
+	llist_impl_copy_storage(&copy, view, track, ntrack);
+	llist_impl_read_end(lst);
+
+	llist_impl_shared_drop(shared);
+	*lst = copy;
+}
+
+static inline void llist_impl_unshare_track(llist_s* lst, lnode_s** track[], size_t ntrack) {
+	if(lst->shared != NULL)
+		llist_impl_unshare_slow(lst, track, ntrack);
+}
+
+static inline void llist_impl_unshare(llist_s* lst) {
+	llist_impl_unshare_track(lst, NULL, 0);
 }
 
 int llist_same_type(llist_s* lhs, llist_s* rhs) {
@@ -59,43 +481,61 @@ void llist_construct_def(llist_s* lst, size_t elem_size) {
 }
 
 void llist_construct_copy(llist_s* lst, const llist_s* other) {
-	llist_impl_init_data(lst, other->elem_size,
-		other->data_alloc_traits, other->node_alloc_traits);
-	lst->data_alloc_obj = lst->data_alloc_traits.copy(other->data_alloc_obj);
-	lst->node_alloc_obj = lst->node_alloc_traits.copy(other->node_alloc_obj);
-
-	llist_assign(lst, other->head, NULL);
+	llist_impl_copy_storage(lst, llist_impl_read_begin(other), NULL, 0);
+	llist_impl_read_end(other);
 }
 
 void llist_construct_move(llist_s* lst, llist_s* other) {
+	llist_impl_unshare(other);
+
 	llist_impl_init_data(lst, other->elem_size,
 		other->data_alloc_traits, other->node_alloc_traits);
 	lst->data_alloc_obj = lst->data_alloc_traits.move(other->data_alloc_obj);
 	lst->node_alloc_obj = lst->node_alloc_traits.move(other->node_alloc_obj);
+	lst->elem_traits    = other->elem_traits;
+	lst->reversed       = other->reversed;
 
 	llist_splice_list(lst, lst->head, other);
 }
 
-void llist_clear(llist_s* lst) {
-	llist_erase_range(lst, lst->head, NULL);
+void llist_construct_snapshot(llist_s* lst, llist_s* other) {
+	if(other->shared == NULL)
+		other->shared = llist_impl_shared_new(other);
+	__atomic_fetch_add(&other->shared->refs, 1, __ATOMIC_RELAXED);
 
-	lst->size = 0;
-	lst->head = NULL;
-	lst->tail = NULL;
+	*lst = *other;
+}
+
+void llist_set_elem_traits(llist_s* lst, const struct elem_traits* traits) {
+	lst->elem_traits = *traits;
+}
+
+void llist_clear(llist_s* lst) {
+	// nodes left with the snapshots are not released
+	if(lst->shared == NULL || llist_impl_leave_shared(lst, 1))
+		llist_erase_range(lst, lst->head, NULL);
+
+	lst->size     = 0;
+	lst->head     = NULL;
+	lst->tail     = NULL;
+	lst->reversed = 0;
 }
 
 void llist_destroy(llist_s* lst) {
-	llist_clear(lst);
-	lst->node_alloc_traits.del(lst->node_alloc_obj);
-	lst->data_alloc_traits.del(lst->data_alloc_obj);
+	if(lst->shared == NULL || llist_impl_leave_shared(lst, 0))
+		llist_impl_destroy_private(lst);
 }
 
 void llist_swap(llist_s* lhs, llist_s* rhs) {
 	assert(llist_same_type(lhs, rhs));
 
+	llist_impl_unshare(lhs);
+	llist_impl_unshare(rhs);
+
 	Macro_util_swap(lnode_s*, lhs->head, rhs->head);
 	Macro_util_swap(lnode_s*, lhs->tail, rhs->tail);
 	Macro_util_swap(size_t,   lhs->size, rhs->size);
+	Macro_util_swap(int,      lhs->reversed, rhs->reversed);
 }
 
 void llist_assign(llist_s* lst, const lnode_s* first, const lnode_s* last) {
@@ -103,9 +543,32 @@ void llist_assign(llist_s* lst, const lnode_s* first, const lnode_s* last) {
 	llist_insert_range(lst, NULL, first, last);
 }
 
+void llist_assign_list(llist_s* lst, const llist_s* src,
+			const lnode_s* first, const lnode_s* last) {
+	if(src == lst) {
+		// keep [first, last) and drop the rest around it
+		lnode_s* f = (lnode_s*) first;
+		lnode_s* l = (lnode_s*) last;
+		lnode_s** track[] = { &f, &l };
+
+		// front first: for an empty range ('f' == 'l') the back erase
+		// frees 'f', which the front erase still has to look at
+		llist_impl_unshare_track(lst, track, 2);
+		llist_erase_range(lst, lst->head, f);
+		llist_erase_range(lst, l, NULL);
+	} else {
+		llist_clear(lst);
+		llist_insert_list_range(lst, NULL, src, first, last);
+	}
+}
+
 void llist_resize(llist_s* lst, size_t size, const void* data) {
+	llist_impl_unshare(lst);
+
 	if(lst->size > size) {
-		lnode_s* p = lnode_advance(lst->head, size);
+		lnode_s* p = lst->head;
+		for(; size > 0; --size)
+			p = llist_next(lst, p);
 		llist_erase_range(lst, p, NULL);
 	} else if(lst->size < size) {
 		size_t i = size - lst->size;
@@ -115,129 +578,174 @@ void llist_resize(llist_s* lst, size_t size, const void* data) {
 }
 
 void llist_push_back(llist_s* lst, const void* data) {
-	lnode_s* new_node = llist_impl_alloc_node(lst);
-	new_node->data    = llist_impl_alloc_data(lst);
+	lnode_s* new_node;
 
-	memcpy(new_node->data, data, lst->elem_size);
+	llist_impl_unshare(lst);
 
-	if(llist_empty(lst)) {
-		lnode_init(new_node);
-		lst->head = new_node;
-	} else
-		lnode_insert_after(lst->tail, new_node);
-
-	lst->tail = new_node;
-	++lst->size;
+	new_node = llist_impl_push_back_uninit(lst);
+	llist_impl_copy_elem(lst, new_node->data, data);
 }
 
 lnode_s* llist_insert(llist_s* lst, lnode_s* pos, const void* data) {
-	if(pos == NULL) {
-		llist_push_back(lst, data);
-		return lst->tail;
-	} else {
-		lnode_s* new_node = llist_impl_alloc_node(lst);
-		new_node->data    = llist_impl_alloc_data(lst);
+	lnode_s* new_node;
+	lnode_s** track[] = { &pos };
 
-		memcpy(new_node->data, data, lst->elem_size);
+	llist_impl_unshare_track(lst, track, 1);
 
-		lnode_insert(pos, new_node);
+	new_node = llist_impl_insert_uninit(lst, pos);
+	llist_impl_copy_elem(lst, new_node->data, data);
 
-		if(pos == lst->head)
-			lst->head = new_node;
+	return new_node;
+}
 
-		++lst->size;
+void* llist_emplace_back(llist_s* lst) {
+	llist_impl_unshare(lst);
+	return llist_impl_push_back_uninit(lst)->data;
+}
 
-		return new_node;
-	}
+void* llist_emplace(llist_s* lst, lnode_s* pos) {
+	lnode_s** track[] = { &pos };
+	llist_impl_unshare_track(lst, track, 1);
+
+	return llist_impl_insert_uninit(lst, pos)->data;
 }
 
 lnode_s* llist_insert_range(llist_s* lst, lnode_s* pos,
 			const lnode_s* first, const lnode_s* last) {
 	lnode_s* ret = 0;
-	while(first != last) {
+	lnode_s** track[] = { &pos };
+
+	llist_impl_unshare_track(lst, track, 1);
+
+	for(; first != last; first = first->next) {
+		lnode_s* new_node = llist_insert(lst, pos, first->data);
 		if(!ret)
-			ret = llist_insert(lst, pos, first->data);
-		first = first->next;
+			ret = new_node;
 	}
 	return ret;
 }
 
+lnode_s* llist_insert_list_range(llist_s* lst, lnode_s* pos,
+			const llist_s* src, const lnode_s* first, const lnode_s* last) {
+	lnode_s* f = (lnode_s*) first;
+	lnode_s* l = (lnode_s*) last;
+	lnode_s** track[] = { &pos, &f, &l };
+	const llist_s* view;
+	llist_s copies;
+
+	llist_impl_unshare_track(lst, track, src == lst ? 3 : 1);
+
+	// copied aside first, 'src' may be 'lst' itself
+	llist_impl_init_borrowed(&copies, lst);
+	view = llist_impl_read_begin(src);
+	for(; f != l; f = llist_next(view, f))
+		llist_impl_copy_elem(lst, llist_impl_push_back_uninit(&copies)->data, f->data);
+	llist_impl_read_end(src);
+
+	if(copies.head == NULL)
+		return NULL;
+
+	llist_impl_link_range(lst, pos, copies.head, copies.tail);
+	lst->size += copies.size;
+	return copies.head;
+}
+
 lnode_s* llist_erase(llist_s* lst, lnode_s* pos) {
-	lnode_s* ret = pos->next;
+	lnode_s* ret;
+	lnode_s** track[] = { &pos };
 
-	if(pos == lst->tail)
-		lst->tail = pos->prev;
-	if(pos == lst->head)
-		lst->head = pos->next;
+	llist_impl_unshare_track(lst, track, 1);
 
-	lnode_detach(pos);
+	ret = llist_next(lst, pos);
 
+	llist_impl_unlink(lst, pos);
+
+	if(lst->elem_traits.destroy != NULL)
+		lst->elem_traits.destroy(pos->data);
 	llist_impl_dealloc_data(lst, pos->data);
 	llist_impl_dealloc_node(lst, pos);
 
-	--lst->size;
-
 	return ret;
 }
 
 lnode_s* llist_erase_range(llist_s* lst, lnode_s* first, lnode_s* last) {
-	lnode_s* ret = 0;
-	while(first != last) {
-		first = llist_erase(lst, first);
-		if(!ret)
-			ret = first;
+	lnode_s** track[] = { &first, &last };
+	llist_impl_unshare_track(lst, track, 2);
+
+	if(first != last) {
+		struct llist_impl_release r;
+		lnode_s* next;
+
+		llist_impl_unlink_range(lst, first,
+			last == NULL ? lst->tail : llist_prev(lst, last));
+
+		llist_impl_release_init(&r);
+		for(; first != last; first = next) {
+			next = llist_next(lst, first);
+			llist_impl_release_push(lst, &r, first);
+		}
+		llist_impl_release_flush(lst, &r);
+		lst->size -= r.total;
 	}
-	return ret;
+	return last;
 }
 
 // splice [first, last) in 'other' to position before 'pos'
 static inline void llist_impl_splice(llist_s* lst, lnode_s* pos,
 			llist_s* other, lnode_s* first, lnode_s* last, size_t count) {
+	lnode_s** track[] = { &first, &last, &pos };
+
 	assert(llist_same_type(lst, other));
-	assert(first != NULL);
+
+	if(first == last)
+		return;
+
+	if(lst == other)
+		llist_impl_unshare_track(lst, track, 3);
+	else {
+		llist_impl_unshare_track(other, track, 2);
+		llist_impl_unshare_track(lst, track + 2, 1);
+	}
 
 	if(llist_impl_allocator_eq(lst, other)) { // same allocator, relink
-		lnode_s* tail = last == NULL ? other->tail : last->prev;
-
-		if(first == other->head)
-			other->head = last;
-		if(last == NULL)
-			other->tail = first->prev;
-
-		if(llist_empty(lst)) {
-			lnode_s node;
-			lnode_init(&node);
-			lnode_splice_range_after(&node, first, tail);
-			lnode_detach(&node);
-
-			lst->head = first;
-			lst->tail = tail;
-		} else {
-			if(pos == lst->head)
-				lst->head = first;
-
-			if(pos != NULL)
-				lnode_splice_range(pos, first, tail);
-			else {
-				lnode_splice_range_after(lst->tail, first, tail);
-				lst->tail = tail;
+		lnode_s* tail = last == NULL ? other->tail : llist_prev(other, last);
+
+		llist_impl_unlink_range(other, first, tail);
+
+		// directions differ, turn the links of the range around
+		if(lst->reversed != other->reversed && first != tail) {
+			lnode_s *p, *next, *end = llist_next(other, tail);
+			for(p = first; p != end; p = next) {
+				next = llist_next(other, p);
+				Macro_util_swap(lnode_s*, p->prev, p->next);
 			}
 		}
 
+		llist_impl_link_range(lst, pos, first, tail);
+
 		if(lst != other) {
 			lst->size   += count;
 			other->size -= count;
 		}
-	} else { // different allocator
-		llist_insert_range(lst, pos, first, last);
-		llist_erase_range(other, first, last);
+	} else { // different allocator, move the payloads over
+		lnode_s *p, *next;
+
+		for(p = first; p != last; p = next) {
+			next = llist_next(other, p);
+
+			llist_impl_move_elem(lst, llist_impl_insert_uninit(lst, pos)->data, p->data);
+
+			llist_impl_unlink(other, p);
+			llist_impl_dealloc_data(other, p->data);
+			llist_impl_dealloc_node(other, p);
+		}
 	}
 }
 
 void llist_splice_range(llist_s* lst, lnode_s* pos,
 			llist_s* other, lnode_s* first, lnode_s* last) {
 	llist_impl_splice(lst, pos, other, first, last,
-		lnode_range_len(first, last ? last->prev : other->tail));
+		llist_impl_range_len(other, first, last));
 }
 
 void llist_splice_list(llist_s* lst, lnode_s* pos, llist_s* other) {
@@ -248,22 +756,86 @@ void llist_splice_list(llist_s* lst, lnode_s* pos, llist_s* other) {
 void llist_splice(llist_s* lst, lnode_s* pos,
 			llist_s* other, lnode_s* node) {
 	if(pos != node)
-		llist_impl_splice(lst, pos, other, node, node->next, 1);
+		llist_impl_splice(lst, pos, other, node, llist_next(other, node), 1);
 }
 
 void llist_for_each(llist_s* lst, unary_func_t f) {
-	lnode_for_each(lst->head, lst->tail, f);
+	lnode_s* p;
+
+	llist_impl_unshare(lst);
+	for(p = lst->head; p != NULL; p = llist_next(lst, p))
+		f(p->data);
+}
+
+void llist_for_each_const(const llist_s* lst, unary_cfunc_t f) {
+	const llist_s* view = llist_impl_read_begin(lst);
+	const lnode_s* p;
+
+	for(p = view->head; p != NULL; p = llist_next(view, p))
+		f(p->data);
+	llist_impl_read_end(lst);
+}
+
+const llist_s* llist_read_begin(const llist_s* lst) {
+	return llist_impl_read_begin(lst);
+}
+
+void llist_read_end(const llist_s* lst) {
+	llist_impl_read_end(lst);
+}
+
+lnode_s* llist_node_create(llist_s* lst, const void* data) {
+	lnode_s* node = llist_impl_alloc_node(lst);
+	node->data    = llist_impl_alloc_data(lst);
+	lnode_init(node);
+
+	if(data != NULL)
+		llist_impl_copy_elem(lst, node->data, data);
+	return node;
+}
+
+size_t llist_node_release_chain(llist_s* lst, lnode_s* first) {
+	return llist_impl_release_chain(lst, first);
+}
+
+lnode_s* llist_detach(llist_s* lst, lnode_s** last) {
+	lnode_s* first;
+
+	llist_impl_unshare(lst);
+	llist_normalize(lst);
+
+	first = lst->head;
+	*last = lst->tail;
+
+	lst->head = NULL;
+	lst->tail = NULL;
+	lst->size = 0;
+	return first;
 }
 
+// the nodes are left alone, only the ends and the flag change
 void llist_reverse(llist_s* lst) {
-	if(lst->head != NULL && lst->tail != NULL) {
-		lnode_reverse(lst->head, lst->tail);
-		Macro_util_swap(lnode_s*, lst->head, lst->tail);
-	}
+	// the snapshots keep the direction they were taken with
+	llist_impl_unshare(lst);
+
+	Macro_util_swap(lnode_s*, lst->head, lst->tail);
+	lst->reversed = !lst->reversed;
+}
+
+void llist_normalize(llist_s* lst) {
+	if(!lst->reversed)
+		return;
+
+	llist_impl_unshare(lst);
+
+	// the raw order runs from the logical tail to the logical head
+	if(lst->size > 1)
+		lnode_reverse(lst->tail, lst->head);
+	lst->reversed = 0;
 }
 
 void llist_merge(llist_s* lst, llist_s* other) {
-	lnode_s *p1 = lst->head, *p2 = other->head;
+	lnode_s *p1, *p2;
 
 	assert(llist_same_type(lst, other));
 	assert(llist_impl_allocator_eq(lst, other));
@@ -271,11 +843,16 @@ void llist_merge(llist_s* lst, llist_s* other) {
 	if(lst == other)
 		return;
 
+	llist_impl_unshare(lst);
+	llist_impl_unshare(other);
+	p1 = lst->head;
+	p2 = other->head;
+
 	while(p1 != NULL && p2 != NULL) {
 		if(memcmp(p1->data, p2->data, lst->elem_size) <= 0)
-			p1 = p1->next;
+			p1 = llist_next(lst, p1);
 		else {
-			lnode_s* next = p2->next;
+			lnode_s* next = llist_next(other, p2);
 			llist_splice(lst, p1, other, p2);
 			p2 = next;
 		}
@@ -288,7 +865,7 @@ void llist_merge(llist_s* lst, llist_s* other) {
 }
 
 void llist_merge_pred(llist_s* lst, llist_s* other, cmp_pred_t cmp) {
-	lnode_s *p1 = lst->head, *p2 = other->head;
+	lnode_s *p1, *p2;
 
 	assert(llist_same_type(lst, other));
 	assert(llist_impl_allocator_eq(lst, other));
@@ -296,11 +873,16 @@ void llist_merge_pred(llist_s* lst, llist_s* other, cmp_pred_t cmp) {
 	if(lst == other)
 		return;
 
+	llist_impl_unshare(lst);
+	llist_impl_unshare(other);
+	p1 = lst->head;
+	p2 = other->head;
+
 	while(p1 != NULL && p2 != NULL) {
 		if(cmp(p1->data, p2->data) <= 0)
-			p1 = p1->next;
+			p1 = llist_next(lst, p1);
 		else {
-			lnode_s* next = p2->next;
+			lnode_s* next = llist_next(other, p2);
 			llist_splice(lst, p1, other, p2);
 			p2 = next;
 		}
@@ -313,64 +895,83 @@ void llist_merge_pred(llist_s* lst, llist_s* other, cmp_pred_t cmp) {
 }
 
 void llist_remove(llist_s* lst, const void* value) {
-	lnode_s* p = lst->head;
-	while(p != NULL) {
-		if(!memcmp(p->data, value, lst->elem_size)) {
-			lnode_s* next = p->next;
-			llist_erase(lst, p);
-			p = next;
-		} else
-			p = p->next;
+	struct llist_impl_filter f;
+	lnode_s *p, *next;
+
+	llist_impl_unshare(lst);
+
+	llist_impl_filter_init(&f);
+	for(p = lst->head; p != NULL; p = next) {
+		next = llist_next(lst, p);
+		if(!memcmp(p->data, value, lst->elem_size))
+			llist_impl_filter_drop(lst, &f, p);
+		else
+			llist_impl_filter_keep(lst, &f, p);
 	}
+	llist_impl_filter_finish(lst, &f);
 }
 
 void llist_remove_pred(llist_s* lst, unary_pred_t pred) {
-	lnode_s* p = lst->head;
-	while(p != NULL) {
-		if(pred(p->data)) {
-			lnode_s* next = p->next;
-			llist_erase(lst, p);
-			p = next;
-		} else
-			p = p->next;
+	struct llist_impl_filter f;
+	lnode_s *p, *next;
+
+	llist_impl_unshare(lst);
+
+	llist_impl_filter_init(&f);
+	for(p = lst->head; p != NULL; p = next) {
+		next = llist_next(lst, p);
+		if(pred(p->data))
+			llist_impl_filter_drop(lst, &f, p);
+		else
+			llist_impl_filter_keep(lst, &f, p);
 	}
+	llist_impl_filter_finish(lst, &f);
 }
 
 void llist_unique(llist_s* lst) {
-	if(lst->head != NULL) {
-		lnode_s* p = lst->head->next;
-		while(p != NULL) {
-			if(!memcmp(p->data, p->prev->data, lst->elem_size)) {
-				lnode_s* next = p->next;
-				llist_erase(lst, p);
-				p = next;
-			} else
-				p = p->next;
-		}
+	struct llist_impl_filter f;
+	lnode_s *p, *next;
+
+	llist_impl_unshare(lst);
+
+	llist_impl_filter_init(&f);
+	for(p = lst->head; p != NULL; p = next) {
+		next = llist_next(lst, p);
+		if(f.kept.tail != NULL && !memcmp(p->data, f.kept.tail->data, lst->elem_size))
+			llist_impl_filter_drop(lst, &f, p);
+		else
+			llist_impl_filter_keep(lst, &f, p);
 	}
+	llist_impl_filter_finish(lst, &f);
 }
 
 void llist_unique_pred(llist_s* lst, eq_pred_t eq) {
-	if(lst->head != NULL) {
-		lnode_s* p = lst->head->next;
-		while(p != NULL) {
-			if(eq(p->data, p->prev->data)) {
-				lnode_s* next = p->next;
-				llist_erase(lst, p);
-				p = next;
-			} else
-				p = p->next;
-		}
+	struct llist_impl_filter f;
+	lnode_s *p, *next;
+
+	llist_impl_unshare(lst);
+
+	llist_impl_filter_init(&f);
+	for(p = lst->head; p != NULL; p = next) {
+		next = llist_next(lst, p);
+		if(f.kept.tail != NULL && eq(p->data, f.kept.tail->data))
+			llist_impl_filter_drop(lst, &f, p);
+		else
+			llist_impl_filter_keep(lst, &f, p);
 	}
+	llist_impl_filter_finish(lst, &f);
 }
 
 void llist_sort(llist_s* lst) {
 	llist_s tmp, bin[64];
 	size_t max = 0, cnt;
-	// initialize
-	llist_construct_def(&tmp, lst->elem_size);
+	if(lst->size < 2)
+		return;
+	llist_impl_unshare(lst);
+	// initialize, nodes are relinked only so the bins borrow lst's allocators
+	llist_impl_init_borrowed(&tmp, lst);
 	for(cnt = 0; cnt < 64; ++cnt)
-		llist_construct_def(&bin[cnt], lst->elem_size);
+		llist_impl_init_borrowed(&bin[cnt], lst);
 	// construct heap
 	while(!llist_empty(lst)) {
 		llist_splice(&tmp, tmp.head, lst, lst->head);
@@ -392,10 +993,13 @@ void llist_sort(llist_s* lst) {
 void llist_sort_pred(llist_s* lst, cmp_pred_t cmp) {
 	llist_s tmp, bin[64];
 	size_t max = 0, cnt;
-	// initialize
-	llist_construct_def(&tmp, lst->elem_size);
+	if(lst->size < 2)
+		return;
+	llist_impl_unshare(lst);
+	// initialize, nodes are relinked only so the bins borrow lst's allocators
+	llist_impl_init_borrowed(&tmp, lst);
 	for(cnt = 0; cnt < 64; ++cnt)
-		llist_construct_def(&bin[cnt], lst->elem_size);
+		llist_impl_init_borrowed(&bin[cnt], lst);
 	// construct heap
 	while(!llist_empty(lst)) {
 		llist_splice(&tmp, tmp.head, lst, lst->head);
@@ -414,46 +1018,205 @@ void llist_sort_pred(llist_s* lst, cmp_pred_t cmp) {
 	llist_splice_list(lst, NULL, &bin[max - 1]);
 }
 
-int llist_empty(const llist_s* lst) {
-	return !lst->size;
+// parallel variants
+
+// segments shorter than this are not worth handing to another thread
+#define LLIST_IMPL_PAR_GRAIN        4096
+#define LLIST_IMPL_PAR_MAX_SEGMENTS 64
+
+struct llist_impl_segment {
+	lnode_s* first;
+	lnode_s* last;      // exclusive
+	lnode_s* dst;       // transform: matching node of the output list
+
+	struct llist_impl_chain kept;   // remove_pred: survivors
+	lnode_s* dropped;   // remove_pred: removed nodes linked through 'next'
+};
+
+struct llist_impl_par {
+	struct llist_impl_segment seg[LLIST_IMPL_PAR_MAX_SEGMENTS];
+	size_t           count;
+
+	const llist_s*   lst;
+	const llist_s*   dst;
+
+	unary_func_ctx_t func;
+	unary_pred_ctx_t pred;
+	transform_func_t transform;
+	void*            ctx;
+};
+
+// cut 'lst' into segments of roughly equal length in one pass, nodes of
+// 'dst' (if not NULL) are cut along
+static void llist_impl_par_cut(struct llist_impl_par* par,
+			const llist_s* lst, const llist_s* dst) {
+	size_t i, len, size = lst->size, threads = thread_pool_size();
+	lnode_s* p = lst->head;
+	lnode_s* q = dst != NULL ? dst->head : NULL;
+
+	par->lst = lst;
+	par->dst = dst;
+
+	par->count = size / LLIST_IMPL_PAR_GRAIN;
+	if(par->count > threads)
+		par->count = threads;
+	if(par->count > LLIST_IMPL_PAR_MAX_SEGMENTS)
+		par->count = LLIST_IMPL_PAR_MAX_SEGMENTS;
+	if(par->count == 0)
+		par->count = 1;
+
+	for(i = 0; i < par->count; ++i) {
+		struct llist_impl_segment* seg = &par->seg[i];
+
+		seg->first = p;
+		seg->dst   = q;
+		for(len = size / par->count + (i < size % par->count); len > 0; --len) {
+			p = llist_next(lst, p);
+			if(q != NULL)
+				q = llist_next(dst, q);
+		}
+		seg->last = p;
+	}
 }
 
-// return 1 if two lists are equal
-int llist_equal_pred(const llist_s* lhs, const llist_s* rhs, eq_pred_t eq) {
-	if(lhs->elem_size != rhs->elem_size || lhs->size != rhs->size)
-		return 0;
-	else {
-		lnode_s *p1 = lhs->head, *p2 = rhs->head;
-		while(p1 != NULL) {
-			if(!eq(p1->data, p2->data))
-				return 0;
+static void llist_impl_par_for_each_task(size_t idx, void* arg) {
+	struct llist_impl_par* par = (struct llist_impl_par*) arg;
+	struct llist_impl_segment* seg = &par->seg[idx];
+	lnode_s* p;
+
+	for(p = seg->first; p != seg->last; p = llist_next(par->lst, p))
+		par->func(p->data, par->ctx);
+}
+
+static void llist_impl_par_remove_task(size_t idx, void* arg) {
+	struct llist_impl_par* par = (struct llist_impl_par*) arg;
+	struct llist_impl_segment* seg = &par->seg[idx];
+	lnode_s *p, *next;
+
+	llist_impl_chain_init(&seg->kept);
+	seg->dropped = NULL;
+
+	// allocators are not thread-safe, removed nodes are only collected here
+	for(p = seg->first; p != seg->last; p = next) {
+		next = llist_next(par->lst, p);
+		if(par->pred(p->data, par->ctx)) {
+			p->next      = seg->dropped;
+			seg->dropped = p;
+		} else
+			llist_impl_chain_append(par->lst, &seg->kept, p);
+	}
+}
+
+static void llist_impl_par_transform_task(size_t idx, void* arg) {
+	struct llist_impl_par* par = (struct llist_impl_par*) arg;
+	struct llist_impl_segment* seg = &par->seg[idx];
+	lnode_s *p, *q;
+
+	for(p = seg->first, q = seg->dst; p != seg->last;
+			p = llist_next(par->lst, p), q = llist_next(par->dst, q))
+		par->transform(q->data, p->data, par->ctx);
+}
+
+void llist_par_for_each(llist_s* lst, unary_func_ctx_t f, void* ctx) {
+	struct llist_impl_par par;
+
+	if(llist_empty(lst))
+		return;
+	llist_impl_unshare(lst);
 
-			p1 = p1->next;
-			p2 = p2->next;
+	llist_impl_par_cut(&par, lst, NULL);
+	par.func = f;
+	par.ctx  = ctx;
+
+	thread_pool_run(par.count, llist_impl_par_for_each_task, &par);
+}
+
+void llist_par_remove_pred(llist_s* lst, unary_pred_ctx_t pred, void* ctx) {
+	struct llist_impl_par par;
+	struct llist_impl_chain kept;
+	size_t i;
+
+	if(llist_empty(lst))
+		return;
+	llist_impl_unshare(lst);
+
+	llist_impl_par_cut(&par, lst, NULL);
+	par.pred = pred;
+	par.ctx  = ctx;
+
+	thread_pool_run(par.count, llist_impl_par_remove_task, &par);
+
+	// stitch the survivors back together, then free the rest
+	llist_impl_chain_init(&kept);
+	for(i = 0; i < par.count; ++i) {
+		struct llist_impl_segment* seg = &par.seg[i];
+
+		if(seg->kept.head != NULL) {
+			*llist_impl_prev_link(lst, seg->kept.head) = kept.tail;
+			if(kept.tail != NULL)
+				*llist_impl_next_link(lst, kept.tail) = seg->kept.head;
+			else
+				kept.head = seg->kept.head;
+			kept.tail = seg->kept.tail;
 		}
+		lst->size -= llist_impl_release_chain(lst, seg->dropped);
 	}
-	return 1;
+	if(kept.tail != NULL)
+		*llist_impl_next_link(lst, kept.tail) = NULL;
+
+	lst->head = kept.head;
+	lst->tail = kept.tail;
 }
 
-// use memcmp
-int llist_equal(const llist_s* lhs, const llist_s* rhs) {
+void llist_par_transform(llist_s* dst, const llist_s* src,
+			transform_func_t f, void* ctx) {
+	struct llist_impl_par par;
+	size_t i;
+
+	const llist_s* view;
+
+	assert(dst != src);
+
+	// nodes are allocated up front, only the payloads are filled in parallel
+	llist_clear(dst);
+	for(i = src->size; i > 0; --i)
+		llist_impl_push_back_uninit(dst);
+
+	if(llist_empty(src))
+		return;
+
+	view = llist_impl_read_begin(src);
+	llist_impl_par_cut(&par, view, dst);
+	par.transform = f;
+	par.ctx       = ctx;
+
+	thread_pool_run(par.count, llist_impl_par_transform_task, &par);
+	llist_impl_read_end(src);
+}
+
+int llist_empty(const llist_s* lst) {
+	return !lst->size;
+}
+
+// eq and cmp NULL use memcmp, the lists are the ones being read
+static int llist_impl_equal(const llist_s* lhs, const llist_s* rhs, eq_pred_t eq) {
+	lnode_s *p1 = lhs->head, *p2 = rhs->head;
+
 	if(lhs->elem_size != rhs->elem_size || lhs->size != rhs->size)
 		return 0;
-	else {
-		lnode_s *p1 = lhs->head, *p2 = rhs->head;
-		while(p1 != NULL) {
-			if(memcmp(p1->data, p2->data, lhs->elem_size))
-				return 0;
 
-			p1 = p1->next;
-			p2 = p2->next;
-		}
+	while(p1 != NULL) {
+		if(eq != NULL ? !eq(p1->data, p2->data)
+		              : memcmp(p1->data, p2->data, lhs->elem_size) != 0)
+			return 0;
+
+		p1 = llist_next(lhs, p1);
+		p2 = llist_next(rhs, p2);
 	}
 	return 1;
 }
 
-// compare lexicographically
-int llist_cmp_pred(const llist_s* lhs, const llist_s* rhs, cmp_pred_t cmp) {
+static int llist_impl_cmp(const llist_s* lhs, const llist_s* rhs, cmp_pred_t cmp) {
 	lnode_s *p1 = lhs->head, *p2 = rhs->head;
 	int ret;
 
@@ -463,35 +1226,42 @@ int llist_cmp_pred(const llist_s* lhs, const llist_s* rhs, cmp_pred_t cmp) {
 		if(p2 == NULL)
 			return 1;
 
-		ret = cmp(p1->data, p2->data);
+		ret = cmp != NULL ? cmp(p1->data, p2->data)
+		                  : memcmp(p1->data, p2->data, lhs->elem_size);
 		if(ret)
 			return ret;
 
-		p1 = p1->next;
-		p2 = p2->next;
+		p1 = llist_next(lhs, p1);
+		p2 = llist_next(rhs, p2);
 	}
 	return 0;
 }
 
-// use memcmp
-int llist_cmp(const llist_s* lhs, const llist_s* rhs) {
-	lnode_s *p1 = lhs->head, *p2 = rhs->head;
-	int ret;
+// return 1 if two lists are equal
+int llist_equal_pred(const llist_s* lhs, const llist_s* rhs, eq_pred_t eq) {
+	int ret = llist_impl_equal(llist_impl_read_begin(lhs), llist_impl_read_begin(rhs), eq);
 
-	assert(lhs->elem_size == rhs->elem_size);
+	llist_impl_read_end(rhs);
+	llist_impl_read_end(lhs);
+	return ret;
+}
 
-	while(p1 != NULL || p2 != NULL) {
-		if(p1 == NULL)
-			return -1;
-		if(p2 == NULL)
-			return 1;
+// use memcmp
+int llist_equal(const llist_s* lhs, const llist_s* rhs) {
+	return llist_equal_pred(lhs, rhs, NULL);
+}
 
-		ret = memcmp(p1->data, p2->data, lhs->elem_size);
-		if(ret)
-			return ret;
+// compare lexicographically
+int llist_cmp_pred(const llist_s* lhs, const llist_s* rhs, cmp_pred_t cmp) {
+	int ret = llist_impl_cmp(llist_impl_read_begin(lhs), llist_impl_read_begin(rhs), cmp);
 
-		p1 = p1->next;
-		p2 = p2->next;
-	}
-	return 0;
+	llist_impl_read_end(rhs);
+	llist_impl_read_end(lhs);
+	return ret;
+}
+
+// use memcmp
+int llist_cmp(const llist_s* lhs, const llist_s* rhs) {
+	assert(lhs->elem_size == rhs->elem_size);
+	return llist_cmp_pred(lhs, rhs, NULL);
 }
@@ -4,17 +4,40 @@
 #include "lnode.h"
 #include "allocator.h"
 
+struct llist_shared;
+
+// element lifecycle hooks, a NULL member treats elements as plain bytes
+// copy(dst, src) and move(dst, src) construct into uninitialized 'dst',
+// a moved-from 'src' is released without being destroyed
+typedef void(*elem_copy_t)(void*, const void*);
+typedef void(*elem_move_t)(void*, void*);
+typedef void(*elem_destroy_t)(void*);
+
+struct elem_traits {
+    elem_copy_t    copy;
+    elem_move_t    move;
+    elem_destroy_t destroy;
+};
+
 struct linked_list {
     lnode_s* head;
     lnode_s* tail;
 
     size_t   elem_size;
     size_t   size;
+    // non-zero while the list is lazily reversed, the logical order then
+    // runs along the 'prev' links, see llist_reverse
+    int      reversed;
+
+    struct elem_traits elem_traits;
 
     struct allocator_traits data_alloc_traits;
     struct allocator_traits node_alloc_traits;
     void*    data_alloc_obj;
     void*    node_alloc_obj;
+
+    // non-NULL while the nodes are shared with snapshots
+    struct llist_shared* shared;
 };
 
 typedef struct linked_list llist_s;
@@ -25,9 +48,26 @@ typedef int(*cmp_pred_t)(const void*, const void*);
 typedef cmp_pred_t eq_pred_t;
 // unary predicate
 typedef int(*unary_pred_t)(const void*);
+// read-only visitor
+typedef void(*unary_cfunc_t)(const void*);
+// context-carrying callbacks for the parallel variants, ctx comes last
+typedef void(*unary_func_ctx_t)(void*, void*);
+typedef int(*unary_pred_ctx_t)(const void*, void*);
+// transform_func(dst, src, ctx)
+typedef void(*transform_func_t)(void*, const void*, void*);
 
 // note: NULL in pos parameter indicates the pass-the-end position
 
+// traverse with these rather than the raw links, which run backwards
+// while the list is reversed
+static inline lnode_s* llist_next(const llist_s* lst, const lnode_s* node) {
+    return lst->reversed ? node->prev : node->next;
+}
+
+static inline lnode_s* llist_prev(const llist_s* lst, const lnode_s* node) {
+    return lst->reversed ? node->next : node->prev;
+}
+
 int llist_same_type(llist_s* lhs, llist_s* rhs);
 
 void llist_construct(llist_s* lst, size_t elem_size,
@@ -36,18 +76,42 @@ void llist_construct(llist_s* lst, size_t elem_size,
 void llist_construct_def(llist_s* lst, size_t elem_size);
 void llist_construct_copy(llist_s* lst, const llist_s* other);
 void llist_construct_move(llist_s* lst, llist_s* other);
+// O(1) copy sharing the nodes of 'other' until either list is modified
+// the list snapshots are taken from keeps its nodes, its first modification
+// hands a copy of them over to the snapshots. the first modification of a
+// snapshot gives it a copy of its own, node pointers passed to that call
+// are translated. snapshots may be read and destroyed on other threads,
+// through the read-only calls or inside a read section. a thread must not
+// modify a list while it holds a read section on one of its snapshots
+void llist_construct_snapshot(llist_s* lst, llist_s* other);
+// read section: traverse the returned list rather than 'lst', the raw
+// head and tail of a snapshot go stale once the original list changes
+const llist_s* llist_read_begin(const llist_s* lst);
+void llist_read_end(const llist_s* lst);
+// set right after construction, copies of the list inherit them
+void llist_set_elem_traits(llist_s* lst, const struct elem_traits* traits);
 
 void llist_clear(llist_s* lst);
 void llist_destroy(llist_s* lst);
 
 void llist_swap(llist_s* lhs, llist_s* rhs);
+// [first, last) of a foreign chain, followed through its raw 'next' links
+// ranges of a list go through llist_assign_list and llist_insert_list_range
 void llist_assign(llist_s* lst, const lnode_s* first, const lnode_s* last);
+// [first, last) of 'src' in its logical order, 'src' may be 'lst' itself
+void llist_assign_list(llist_s* lst, const llist_s* src,
+            const lnode_s* first, const lnode_s* last);
 void llist_resize(llist_s* lst, size_t size, const void* data);
 
 void llist_push_back(llist_s* lst, const void* data);
 lnode_s* llist_insert(llist_s* lst, lnode_s* pos, const void* data);
+// link a new node and return its uninitialized payload to construct in place
+void* llist_emplace_back(llist_s* lst);
+void* llist_emplace(llist_s* lst, lnode_s* pos);
 lnode_s* llist_insert_range(llist_s* lst, lnode_s* pos,
             const lnode_s* first, const lnode_s* last);
+lnode_s* llist_insert_list_range(llist_s* lst, lnode_s* pos,
+            const llist_s* src, const lnode_s* first, const lnode_s* last);
 lnode_s* llist_erase(llist_s* lst, lnode_s* pos);
 lnode_s* llist_erase_range(llist_s* lst, lnode_s* first, lnode_s* last);
 
@@ -56,9 +120,27 @@ void llist_splice_range(llist_s* lst, lnode_s* pos, llist_s* other,
 void llist_splice_list(llist_s* lst, lnode_s* pos, llist_s* other);
 void llist_splice(llist_s* lst, lnode_s* pos, llist_s* other, lnode_s* node);
 
+// f may modify the elements, a shared list gets private storage first
 void llist_for_each(llist_s* lst, unary_func_t f);
-
+// read-only, leaves snapshots shared
+void llist_for_each_const(const llist_s* lst, unary_cfunc_t f);
+
+// detached nodes, for containers that manage the links themselves
+// a node from the allocators of 'lst', its payload copied from 'data' or
+// left uninitialized if 'data' is NULL
+lnode_s* llist_node_create(llist_s* lst, const void* data);
+// destroy and release a detached, NULL-terminated chain linked through 'next'
+// return the number of released nodes
+size_t llist_node_release_chain(llist_s* lst, lnode_s* first);
+// unlink every node into a NULL-terminated chain in logical order, return
+// its head and store its tail to 'last', 'lst' is left empty
+lnode_s* llist_detach(llist_s* lst, lnode_s** last);
+
+// O(1), only flips the direction of the list, a list shared with
+// snapshots gets private storage first
 void llist_reverse(llist_s* lst);
+// relink the nodes so that the raw links follow the logical order again
+void llist_normalize(llist_s* lst);
 void llist_merge(llist_s* lst, llist_s* other);
 void llist_merge_pred(llist_s* lst, llist_s* other, cmp_pred_t cmp);
 void llist_remove(llist_s* lst, const void* value);
@@ -68,6 +150,14 @@ void llist_unique_pred(llist_s* lst, cmp_pred_t cmp);
 void llist_sort(llist_s* lst);
 void llist_sort_pred(llist_s* lst, cmp_pred_t cmp);
 
+// parallel variants: the list is cut into segments processed concurrently
+// callbacks run on several threads at once and must be thread-safe
+void llist_par_for_each(llist_s* lst, unary_func_ctx_t f, void* ctx);
+void llist_par_remove_pred(llist_s* lst, unary_pred_ctx_t pred, void* ctx);
+// replace the content of 'dst' with f applied to every element of 'src'
+void llist_par_transform(llist_s* dst, const llist_s* src,
+            transform_func_t f, void* ctx);
+
 int llist_empty(const llist_s* lst);
 int llist_equal_pred(const llist_s* lhs, const llist_s* rhs, eq_pred_t eq);
 int llist_equal(const llist_s* lhs, const llist_s* rhs);
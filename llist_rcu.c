@@ -0,0 +1,265 @@
+#include "llist_rcu.h"
+#include "compat.h"
+#include <stdlib.h>
+#include <sched.h>
+#include <assert.h>
+
+// retire this many nodes before trying to release them
+#define LLIST_RCU_IMPL_RECLAIM_AT 64
+
+// nodes unlinked during one epoch, chained through 'prev' which readers
+// never follow
+struct llist_rcu_retired {
+	struct llist_rcu_retired* next;
+	unsigned long             epoch;
+	lnode_s*                  nodes;
+};
+
+// store a link readers may be following, everything written to the nodes
+// before is visible to a reader that loads the new value
+static inline void llist_rcu_impl_publish(lnode_s** link, lnode_s* node) {
+	__atomic_store_n(link, node, __ATOMIC_RELEASE);
+}
+
+// link the private chain [first, last] before 'pos'
+static void llist_rcu_impl_link_range(llist_rcu_s* rl, lnode_s* pos,
+			lnode_s* first, lnode_s* last) {
+	llist_s* lst    = &rl->list;
+	lnode_s* before = pos != NULL ? pos->prev : lst->tail;
+
+	first->prev = before;
+	last->next  = pos;
+
+	llist_rcu_impl_publish(before != NULL ? &before->next : &lst->head, first);
+
+	if(pos != NULL)
+		pos->prev = last;
+	else
+		lst->tail = last;
+}
+
+static void llist_rcu_impl_retire(llist_rcu_s* rl, lnode_s* node) {
+	struct llist_rcu_retired* r = rl->retired;
+
+	if(r == NULL || r->epoch != rl->epoch) {
+		r = (struct llist_rcu_retired*) malloc(sizeof(*r));
+		r->next  = rl->retired;
+		r->epoch = rl->epoch;
+		r->nodes = NULL;
+		rl->retired = r;
+	}
+
+	node->prev = r->nodes;
+	r->nodes   = node;
+	++rl->retired_cnt;
+}
+
+// readers in a section keep following the 'next' link of 'pos'
+static void llist_rcu_impl_unlink(llist_rcu_s* rl, lnode_s* pos) {
+	llist_s* lst    = &rl->list;
+	lnode_s* before = pos->prev;
+	lnode_s* after  = pos->next;
+
+	llist_rcu_impl_publish(before != NULL ? &before->next : &lst->head, after);
+
+	if(after != NULL)
+		after->prev = before;
+	else
+		lst->tail = before;
+
+	--lst->size;
+	llist_rcu_impl_retire(rl, pos);
+}
+
+// release the nodes of 'r' and of all older records
+static void llist_rcu_impl_release(llist_rcu_s* rl, struct llist_rcu_retired* r) {
+	lnode_s* chain = NULL;
+	lnode_s* p;
+	struct llist_rcu_retired* next;
+
+	// relink through 'next' so that the whole lot goes in one batch
+	for(; r != NULL; r = next) {
+		next = r->next;
+		while((p = r->nodes) != NULL) {
+			r->nodes = p->prev;
+			p->next  = chain;
+			chain    = p;
+		}
+		free(r);
+	}
+	rl->retired_cnt -= llist_node_release_chain(&rl->list, chain);
+}
+
+// called with the writer lock held
+static void llist_rcu_impl_reclaim(llist_rcu_s* rl) {
+	struct llist_rcu_retired** link = &rl->retired;
+	struct llist_rcu_reader* reader;
+	unsigned long oldest;
+
+	if(rl->retired == NULL)
+		return;
+
+	// readers entering from now on cannot reach anything retired so far
+	if(rl->retired->epoch == rl->epoch)
+		__atomic_store_n(&rl->epoch, rl->epoch + 1, __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	oldest = rl->epoch;
+	for(reader = rl->readers; reader != NULL; reader = reader->next) {
+		unsigned long e = __atomic_load_n(&reader->epoch, __ATOMIC_ACQUIRE);
+		if(e != 0 && e < oldest)
+			oldest = e;
+	}
+
+	// records are ordered newest first
+	while(*link != NULL && (*link)->epoch >= oldest)
+		link = &(*link)->next;
+	llist_rcu_impl_release(rl, *link);
+	*link = NULL;
+}
+
+static inline void llist_rcu_impl_maybe_reclaim(llist_rcu_s* rl) {
+	if(rl->retired_cnt >= LLIST_RCU_IMPL_RECLAIM_AT)
+		llist_rcu_impl_reclaim(rl);
+}
+
+void llist_rcu_construct(llist_rcu_s* rl, size_t elem_size,
+			const struct allocator_traits data_alloc_traits,
+			const struct allocator_traits node_alloc_traits) {
+	llist_construct(&rl->list, elem_size, data_alloc_traits, node_alloc_traits);
+	pthread_mutex_init(&rl->writer, NULL);
+
+	rl->epoch       = 1;
+	rl->readers     = NULL;
+	rl->retired     = NULL;
+	rl->retired_cnt = 0;
+}
+
+void llist_rcu_construct_def(llist_rcu_s* rl, size_t elem_size) {
+	llist_rcu_construct(rl, elem_size, default_allocator, default_allocator);
+}
+
+void llist_rcu_set_elem_traits(llist_rcu_s* rl, const struct elem_traits* traits) {
+	llist_set_elem_traits(&rl->list, traits);
+}
+
+void llist_rcu_destroy(llist_rcu_s* rl) {
+	assert(rl->readers == NULL);
+
+	llist_rcu_impl_release(rl, rl->retired);
+	rl->retired = NULL;
+
+	llist_destroy(&rl->list);
+	pthread_mutex_destroy(&rl->writer);
+}
+
+void llist_rcu_register(llist_rcu_s* rl, struct llist_rcu_reader* reader) {
+	reader->epoch = 0;
+
+	pthread_mutex_lock(&rl->writer);
+	reader->next = rl->readers;
+	rl->readers  = reader;
+	pthread_mutex_unlock(&rl->writer);
+}
+
+void llist_rcu_unregister(llist_rcu_s* rl, struct llist_rcu_reader* reader) {
+	struct llist_rcu_reader** link;
+
+	assert(reader->epoch == 0);
+
+	pthread_mutex_lock(&rl->writer);
+	for(link = &rl->readers; *link != reader; link = &(*link)->next)
+		;
+	*link = reader->next;
+	pthread_mutex_unlock(&rl->writer);
+}
+
+void llist_rcu_push_back(llist_rcu_s* rl, const void* data) {
+	llist_rcu_insert(rl, NULL, data);
+}
+
+lnode_s* llist_rcu_insert(llist_rcu_s* rl, lnode_s* pos, const void* data) {
+	lnode_s* node;
+
+	// a NULL 'data' would publish an uninitialized payload
+	assert(data != NULL);
+
+	pthread_mutex_lock(&rl->writer);
+	// the allocators are only used under the writer lock
+	node = llist_node_create(&rl->list, data);
+	llist_rcu_impl_link_range(rl, pos, node, node);
+	++rl->list.size;
+	pthread_mutex_unlock(&rl->writer);
+
+	return node;
+}
+
+void llist_rcu_erase(llist_rcu_s* rl, lnode_s* pos) {
+	pthread_mutex_lock(&rl->writer);
+	llist_rcu_impl_unlink(rl, pos);
+	llist_rcu_impl_maybe_reclaim(rl);
+	pthread_mutex_unlock(&rl->writer);
+}
+
+void llist_rcu_remove_pred(llist_rcu_s* rl, unary_pred_t pred) {
+	lnode_s* p;
+	lnode_s* next;
+
+	pthread_mutex_lock(&rl->writer);
+	for(p = rl->list.head; p != NULL; p = next) {
+		next = p->next;
+		if(pred(p->data))
+			llist_rcu_impl_unlink(rl, p);
+	}
+	llist_rcu_impl_maybe_reclaim(rl);
+	pthread_mutex_unlock(&rl->writer);
+}
+
+void llist_rcu_splice_list(llist_rcu_s* rl, lnode_s* pos, llist_s* other) {
+	lnode_s* first;
+	lnode_s* last;
+	size_t count = other->size;
+
+	assert(llist_same_type(&rl->list, other));
+	assert(rl->list.node_alloc_traits.eq(rl->list.node_alloc_obj, other->node_alloc_obj)
+	    && rl->list.data_alloc_traits.eq(rl->list.data_alloc_obj, other->data_alloc_obj));
+
+	first = llist_detach(other, &last);
+	if(first == NULL)
+		return;
+
+	pthread_mutex_lock(&rl->writer);
+	llist_rcu_impl_link_range(rl, pos, first, last);
+	rl->list.size += count;
+	pthread_mutex_unlock(&rl->writer);
+}
+
+void llist_rcu_reclaim(llist_rcu_s* rl) {
+	pthread_mutex_lock(&rl->writer);
+	llist_rcu_impl_reclaim(rl);
+	pthread_mutex_unlock(&rl->writer);
+}
+
+void llist_rcu_synchronize(llist_rcu_s* rl) {
+	pthread_mutex_lock(&rl->writer);
+	for(;;) {
+		llist_rcu_impl_reclaim(rl);
+		if(rl->retired == NULL)
+			break;
+
+		pthread_mutex_unlock(&rl->writer);
+		sched_yield();
+		pthread_mutex_lock(&rl->writer);
+	}
+	pthread_mutex_unlock(&rl->writer);
+}
+
+size_t llist_rcu_size(llist_rcu_s* rl) {
+	size_t size;
+
+	pthread_mutex_lock(&rl->writer);
+	size = rl->list.size;
+	pthread_mutex_unlock(&rl->writer);
+
+	return size;
+}
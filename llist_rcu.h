@@ -0,0 +1,91 @@
+#ifndef LLIST_RCU_H_GUARD_
+#define LLIST_RCU_H_GUARD_
+
+#include "llist.h"
+#include <pthread.h>
+
+// per-thread reader state, registered with a list before its first read
+// section, 'epoch' is 0 while the thread is outside of one
+struct llist_rcu_reader {
+	struct llist_rcu_reader* next;
+	unsigned long            epoch;
+};
+
+// unlinked nodes waiting for the readers that may still see them
+struct llist_rcu_retired;
+
+// read-mostly list: readers walk it without locks or read-modify-writes
+// while writers publish changes with release stores. readers only follow
+// 'head' and 'next', nodes unlinked by writers keep their 'next' link and
+// are released once every read section that may have seen them has ended
+struct llist_rcu {
+	llist_s                   list;      // never reversed nor shared
+	pthread_mutex_t           writer;    // writers and reader registration
+
+	unsigned long             epoch;     // starts at 1, 0 marks a quiescent reader
+	struct llist_rcu_reader*  readers;
+	struct llist_rcu_retired* retired;   // newest epoch first
+	size_t                    retired_cnt;
+};
+
+typedef struct llist_rcu llist_rcu_s;
+
+void llist_rcu_construct(llist_rcu_s* rl, size_t elem_size,
+            const struct allocator_traits data_alloc_traits,
+            const struct allocator_traits node_alloc_traits);
+void llist_rcu_construct_def(llist_rcu_s* rl, size_t elem_size);
+// set right after construction
+void llist_rcu_set_elem_traits(llist_rcu_s* rl, const struct elem_traits* traits);
+// no reader may be registered any more
+void llist_rcu_destroy(llist_rcu_s* rl);
+
+// reader side
+
+void llist_rcu_register(llist_rcu_s* rl, struct llist_rcu_reader* reader);
+void llist_rcu_unregister(llist_rcu_s* rl, struct llist_rcu_reader* reader);
+
+// nodes reached between lock and unlock stay valid until unlock
+// read sections of one reader do not nest
+static inline void llist_rcu_read_lock(llist_rcu_s* rl, struct llist_rcu_reader* reader) {
+	__atomic_store_n(&reader->epoch,
+		__atomic_load_n(&rl->epoch, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+	// the announcement must be visible before any node is loaded
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void llist_rcu_read_unlock(struct llist_rcu_reader* reader) {
+	__atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+}
+
+static inline lnode_s* llist_rcu_first(const llist_rcu_s* rl) {
+	return __atomic_load_n(&rl->list.head, __ATOMIC_ACQUIRE);
+}
+
+static inline lnode_s* llist_rcu_next(const lnode_s* node) {
+	return __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+}
+
+// writer side, writers are serialized internally
+// positions are nodes currently in the list, NULL is the pass-the-end one
+
+// payloads are copied from 'data', which must not be NULL, before the
+// node is published and are never modified while it is in the list
+void llist_rcu_push_back(llist_rcu_s* rl, const void* data);
+lnode_s* llist_rcu_insert(llist_rcu_s* rl, lnode_s* pos, const void* data);
+void llist_rcu_erase(llist_rcu_s* rl, lnode_s* pos);
+// erase every element pred returns non-zero for
+void llist_rcu_remove_pred(llist_rcu_s* rl, unary_pred_t pred);
+// move all elements of the private list 'other' before 'pos' at once,
+// 'other' must share the allocators of the list
+void llist_rcu_splice_list(llist_rcu_s* rl, lnode_s* pos, llist_s* other);
+
+// release the retired nodes no reader can see any more
+void llist_rcu_reclaim(llist_rcu_s* rl);
+// wait until every retired node has been released, must not be called
+// from inside a read section
+void llist_rcu_synchronize(llist_rcu_s* rl);
+
+// takes the writer lock
+size_t llist_rcu_size(llist_rcu_s* rl);
+
+#endif
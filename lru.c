@@ -0,0 +1,185 @@
+#include "lru.h"
+#include "compat.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// values are placed at an offset suitable for any type
+union lru_impl_max_align {
+	long double ld;
+	long long   ll;
+	void*       p;
+	void      (*f)(void);
+};
+
+static size_t lru_impl_fnv1a(const void* key, size_t size) {
+	const unsigned char* p = (const unsigned char*) key;
+	size_t h = (size_t) 14695981039346656037ULL;
+
+	for(; size > 0; --size, ++p) {
+		h ^= *p;
+		h *= (size_t) 1099511628211ULL;
+	}
+	return h;
+}
+
+static inline int lru_impl_key_eq(const lru_s* lru, const void* lhs, const void* rhs) {
+	return lru->key_eq != NULL ? lru->key_eq(lhs, rhs) : !memcmp(lhs, rhs, lru->key_size);
+}
+
+static inline size_t lru_impl_home(const lru_s* lru, const void* key) {
+	size_t h = lru->hash != NULL ? lru->hash(key, lru->key_size)
+	                             : lru_impl_fnv1a(key, lru->key_size);
+	return h & lru->index_mask;
+}
+
+static inline void* lru_impl_value(const lru_s* lru, lnode_s* node) {
+	return (char*) node->data + lru->value_offset;
+}
+
+// return the slot holding 'key', or the empty slot where it would go
+static size_t lru_impl_find(const lru_s* lru, const void* key) {
+	size_t i = lru_impl_home(lru, key);
+
+	while(lru->index[i] != NULL && !lru_impl_key_eq(lru, key, lru->index[i]->data))
+		i = (i + 1) & lru->index_mask;
+	return i;
+}
+
+// empty slot 'i', shifting back later entries of the probe run so that
+// no tombstones are needed
+static void lru_impl_index_remove(lru_s* lru, size_t i) {
+	size_t j = i, home;
+
+	lru->index[i] = NULL;
+	for(;;) {
+		j = (j + 1) & lru->index_mask;
+		if(lru->index[j] == NULL)
+			break;
+
+		// entries whose home lies cyclically in (i, j] stay put
+		home = lru_impl_home(lru, lru->index[j]->data);
+		if(i <= j ? (i < home && home <= j) : (i < home || home <= j))
+			continue;
+
+		lru->index[i] = lru->index[j];
+		lru->index[j] = NULL;
+		i = j;
+	}
+}
+
+static void lru_impl_drop_oldest(lru_s* lru) {
+	lnode_s* node = lru->list.tail;
+
+	if(lru->on_evict != NULL)
+		lru->on_evict(node->data, lru_impl_value(lru, node), lru->evict_ctx);
+
+	lru_impl_index_remove(lru, lru_impl_find(lru, node->data));
+	llist_splice(&lru->spare, lru->spare.head, &lru->list, node);
+}
+
+void lru_construct(lru_s* lru, size_t capacity, size_t key_size,
+			size_t value_size, lru_hash_t hash, eq_pred_t key_eq) {
+	size_t align = sizeof(union lru_impl_max_align), slots = 8;
+
+	assert(capacity > 0);
+
+	lru->capacity     = capacity;
+	lru->key_size     = key_size;
+	lru->value_size   = value_size;
+	lru->value_offset = (key_size + align - 1) / align * align;
+
+	lru->hash         = hash;
+	lru->key_eq       = key_eq;
+	lru->on_evict     = NULL;
+	lru->evict_ctx    = NULL;
+
+	// keep the load factor at or below 1/2
+	while(slots < capacity * 2)
+		slots *= 2;
+	lru->index      = (lnode_s**) calloc(slots, sizeof(lnode_s*));
+	lru->index_mask = slots - 1;
+
+	llist_construct_def(&lru->list, lru->value_offset + value_size);
+	llist_construct_def(&lru->spare, lru->value_offset + value_size);
+}
+
+void lru_set_evict(lru_s* lru, lru_evict_t on_evict, void* ctx) {
+	lru->on_evict  = on_evict;
+	lru->evict_ctx = ctx;
+}
+
+void lru_destroy(lru_s* lru) {
+	llist_destroy(&lru->list);
+	llist_destroy(&lru->spare);
+	free(lru->index);
+}
+
+void* lru_get(lru_s* lru, const void* key) {
+	lnode_s* node = lru->index[lru_impl_find(lru, key)];
+
+	if(node == NULL)
+		return NULL;
+
+	llist_splice(&lru->list, lru->list.head, &lru->list, node);
+	return lru_impl_value(lru, node);
+}
+
+void* lru_peek(const lru_s* lru, const void* key) {
+	lnode_s* node = lru->index[lru_impl_find(lru, key)];
+	return node != NULL ? lru_impl_value(lru, node) : NULL;
+}
+
+int lru_touch(lru_s* lru, const void* key) {
+	return lru_get(lru, key) != NULL;
+}
+
+void* lru_put(lru_s* lru, const void* key, const void* value) {
+	size_t   slot = lru_impl_find(lru, key);
+	lnode_s* node = lru->index[slot];
+
+	if(node == NULL) {
+		if(lru->list.size == lru->capacity) {
+			lru_impl_drop_oldest(lru);
+			// the removal may have shifted the probe run
+			slot = lru_impl_find(lru, key);
+		}
+
+		if(!llist_empty(&lru->spare))
+			llist_splice(&lru->list, lru->list.head, &lru->spare, lru->spare.head);
+		else
+			llist_emplace(&lru->list, lru->list.head);
+
+		node = lru->list.head;
+		memcpy(node->data, key, lru->key_size);
+		lru->index[slot] = node;
+	} else
+		llist_splice(&lru->list, lru->list.head, &lru->list, node);
+
+	memcpy(lru_impl_value(lru, node), value, lru->value_size);
+	return lru_impl_value(lru, node);
+}
+
+int lru_erase(lru_s* lru, const void* key) {
+	size_t   slot = lru_impl_find(lru, key);
+	lnode_s* node = lru->index[slot];
+
+	if(node == NULL)
+		return 0;
+
+	lru_impl_index_remove(lru, slot);
+	llist_splice(&lru->spare, lru->spare.head, &lru->list, node);
+	return 1;
+}
+
+int lru_evict_oldest(lru_s* lru) {
+	if(llist_empty(&lru->list))
+		return 0;
+
+	lru_impl_drop_oldest(lru);
+	return 1;
+}
+
+size_t lru_size(const lru_s* lru) {
+	return lru->list.size;
+}
@@ -0,0 +1,57 @@
+#ifndef LRU_H_GUARD_
+#define LRU_H_GUARD_
+
+#include "llist.h"
+
+// hash(key, key_size)
+typedef size_t(*lru_hash_t)(const void*, size_t);
+// on_evict(key, value, ctx) is called before an entry is dropped to make room
+typedef void(*lru_evict_t)(const void*, void*, void*);
+
+// fixed-capacity cache of key/value pairs kept in recency order
+// get, put, touch and evict_oldest are O(1), nodes of evicted or erased
+// entries are recycled so a full cache does not allocate
+struct lru_cache {
+	llist_s     list;       // most recently used first
+	llist_s     spare;      // unlinked nodes waiting for reuse
+
+	lnode_s**   index;      // open addressing, linear probing, NULL is empty
+	size_t      index_mask;
+
+	size_t      capacity;
+	size_t      key_size;
+	size_t      value_size;
+	size_t      value_offset;
+
+	lru_hash_t  hash;
+	eq_pred_t   key_eq;
+	lru_evict_t on_evict;
+	void*       evict_ctx;
+};
+
+typedef struct lru_cache lru_s;
+
+// NULL hash and key_eq hash and compare the key bytes
+void lru_construct(lru_s* lru, size_t capacity, size_t key_size,
+            size_t value_size, lru_hash_t hash, eq_pred_t key_eq);
+void lru_set_evict(lru_s* lru, lru_evict_t on_evict, void* ctx);
+// on_evict is not called for entries still cached
+void lru_destroy(lru_s* lru);
+
+// return the value of 'key' and mark it most recently used, NULL if absent
+void* lru_get(lru_s* lru, const void* key);
+// same as lru_get, recency is left alone
+void* lru_peek(const lru_s* lru, const void* key);
+// return non-zero if 'key' was present
+int lru_touch(lru_s* lru, const void* key);
+// insert or overwrite, evicting the oldest entry when full
+// return the stored value
+void* lru_put(lru_s* lru, const void* key, const void* value);
+// return non-zero if 'key' was present
+int lru_erase(lru_s* lru, const void* key);
+// return non-zero if an entry was evicted
+int lru_evict_oldest(lru_s* lru);
+
+size_t lru_size(const lru_s* lru);
+
+#endif
@@ -0,0 +1,111 @@
+#include "thread_pool.h"
+#include "utils.h"
+#include <pthread.h>
+#include <unistd.h>
+
+#define THREAD_POOL_MAX_WORKERS 63
+
+// one job at a time, indices are handed out under the lock
+static struct {
+	pthread_once_t     once;
+	pthread_mutex_t    submit;
+	pthread_mutex_t    lock;
+	pthread_cond_t     wake;
+	pthread_cond_t     done;
+
+	size_t             workers;
+	unsigned long      generation;
+
+	thread_pool_task_t task;
+	void*              ctx;
+	size_t             count;
+	size_t             next;
+	size_t             pending;
+} pool = {
+	PTHREAD_ONCE_INIT,
+	PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	0, 0, NULL, NULL, 0, 0, 0
+};
+
+// called with pool.lock held
+static void thread_pool_impl_drain(void) {
+	while(pool.next < pool.count) {
+		size_t idx = pool.next++;
+
+		pthread_mutex_unlock(&pool.lock);
+		pool.task(idx, pool.ctx);
+		pthread_mutex_lock(&pool.lock);
+
+		if(--pool.pending == 0)
+			pthread_cond_broadcast(&pool.done);
+	}
+}
+
+static void* thread_pool_impl_worker(void* arg) {
+	unsigned long seen = 0;
+
+	Macro_declare_unused(arg);
+
+	pthread_mutex_lock(&pool.lock);
+	for(;;) {
+		while(pool.generation == seen)
+			pthread_cond_wait(&pool.wake, &pool.lock);
+		seen = pool.generation;
+		thread_pool_impl_drain();
+	}
+	return NULL;
+}
+
+static void thread_pool_impl_init(void) {
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t want = ncpu > 1 ? (size_t) ncpu - 1 : 0;
+
+	if(want > THREAD_POOL_MAX_WORKERS)
+		want = THREAD_POOL_MAX_WORKERS;
+
+	for(; pool.workers < want; ++pool.workers) {
+		pthread_t th;
+		if(pthread_create(&th, NULL, thread_pool_impl_worker, NULL) != 0)
+			break;
+		pthread_detach(th);
+	}
+}
+
+size_t thread_pool_size(void) {
+	pthread_once(&pool.once, thread_pool_impl_init);
+	return pool.workers + 1;
+}
+
+void thread_pool_run(size_t count, thread_pool_task_t task, void* ctx) {
+	size_t idx;
+
+	if(count == 0)
+		return;
+
+	if(count == 1 || thread_pool_size() == 1) {
+		for(idx = 0; idx < count; ++idx)
+			task(idx, ctx);
+		return;
+	}
+
+	pthread_mutex_lock(&pool.submit);
+	pthread_mutex_lock(&pool.lock);
+
+	pool.task    = task;
+	pool.ctx     = ctx;
+	pool.count   = count;
+	pool.next    = 0;
+	pool.pending = count;
+	++pool.generation;
+	pthread_cond_broadcast(&pool.wake);
+
+	thread_pool_impl_drain();
+	while(pool.pending != 0)
+		pthread_cond_wait(&pool.done, &pool.lock);
+
+	pthread_mutex_unlock(&pool.lock);
+	pthread_mutex_unlock(&pool.submit);
+}
@@ -0,0 +1,16 @@
+#ifndef THREAD_POOL_H_GUARD_
+#define THREAD_POOL_H_GUARD_
+
+#include <stddef.h>
+
+// task(index, ctx) is called once for every index in [0, count)
+typedef void(*thread_pool_task_t)(size_t, void*);
+
+// number of threads taking part in thread_pool_run, the caller included
+size_t thread_pool_size(void);
+
+// run 'count' tasks on the shared pool and wait for all of them
+// tasks shall not call thread_pool_run themselves
+void thread_pool_run(size_t count, thread_pool_task_t task, void* ctx);
+
+#endif